@@ -29,16 +29,28 @@
 /* MODIFIED FROM AFL++。 TODO: Don't hard code embed linux */
 /* Try to find a specific runtime we need, returns NULL on fail. */
 
+enum LTOKind { LTOK_None, LTOK_Full, LTOK_Thin };
+
 struct FrontEndOpt {
   // Middle-end options could not transfer to the asm compilation.
   u8 AsmAsSource;
   /* -no-integrated-as , 0 dy default */
   u8 DisableIntegratedAS;
   u8 SanitizeAddressGlobalsDeadStripping;
+  /* -flto[=full|thin], -fno-lto */
+  enum LTOKind lto;
+  /* -fthinlto-index=, i.e., a distributed ThinLTO backend */
+  u8 ThinLTOBackend;
+  /* The optimization level of LTO, i.e., the last -O<level>, or else the
+     default -O2 of lld */
+  u8 LTOOptLevel;
   enum ObjectFormatType obj_format;
 } frontend_opt = {.AsmAsSource = 0,
                   .DisableIntegratedAS = 0,
                   .SanitizeAddressGlobalsDeadStripping = 1,
+                  .lto = LTOK_None,
+                  .ThinLTOBackend = 0,
+                  .LTOOptLevel = 2,
 // { MachO, COFF, ELF, GOFF, XCOFF, UnknownObjectFormat };
 #if defined(__APPLE__)
                   .obj_format = MachO
@@ -349,13 +361,8 @@ static void add_pass_options(enum SanitizerType sanTy) {
   }
 }
 
-/// Pass is a specific feature for clang/LLVM
-static void regist_pass_plugin(enum SanitizerType sanTy) {
-  /**
-   * Need to enable corresponding llvm optimization level,
-   * where your pass is registed.
-   */
-  u8 *san_pass = "";
+static u8 *get_pass_plugin(enum SanitizerType sanTy) {
+  u8 *san_pass;
   switch (sanTy) {
   case ASan:
     san_pass = "ASanInstPass.so";
@@ -372,8 +379,20 @@ static void regist_pass_plugin(enum SanitizerType sanTy) {
   case UBSan:
   case SanNone:
   default:
-    return;
+    return NULL;
   }
+  return alloc_printf("%s/" XSAN_PASS_DIR "/%s", obj_path, san_pass);
+}
+
+/// Pass is a specific feature for clang/LLVM
+static void regist_pass_plugin(enum SanitizerType sanTy) {
+  /**
+   * Need to enable corresponding llvm optimization level,
+   * where your pass is registed.
+   */
+  u8 *san_pass = get_pass_plugin(sanTy);
+  if (!san_pass)
+    return;
 
   /* The relevant code in Frontend/CompilerInvocation.cpp:CreateFromArgsImpl
     // FIXME: Override value name discarding when asan or msan is used because
@@ -388,8 +407,6 @@ static void regist_pass_plugin(enum SanitizerType sanTy) {
    */
   cc_params[cc_par_cnt++] = "-fno-discard-value-names";
 
-  san_pass = alloc_printf("%s/" XSAN_PASS_DIR "/%s", obj_path, san_pass);
-
   /*
     From this issue https://github.com/llvm/llvm-project/issues/56137
     To pass the option to plugin pass, we need add extra options
@@ -419,6 +436,51 @@ static void regist_pass_plugin(enum SanitizerType sanTy) {
   }
 }
 
+/* Under (Thin)LTO, XSan instruments the modules in the linker, after the
+   cross-module inlining, instead of each translation unit on its own.
+   - The pre-link compilations leave the instrumentation to the linker.
+   - The linker loads the pass plugin, and receives the middle-end options
+     through XSAN_LTO_OPTIONS_ENV as it parses -mllvm before loading plugins.
+   - The ThinLTO backend instruments at the end of its pipeline, while the
+     full LTO pipeline of LLVM 15 has no such extension point, so the pass
+     "xsan-lto" is appended to it explicitly. So is it at -O0, where neither
+     pipeline runs the extension points.
+   - A distributed ThinLTO backend (-fthinlto-index=) instruments in clang. */
+static void add_lto_options(enum SanitizerType sanTy, u8 have_c) {
+  if (sanTy != XSan)
+    return;
+
+  if (frontend_opt.ThinLTOBackend) {
+    ADD_LLVM_MIDDLE_END_OPTION("-xsan-lto=post-link");
+    return;
+  }
+  if (frontend_opt.lto == LTOK_None)
+    return;
+  ADD_LLVM_MIDDLE_END_OPTION("-xsan-lto=pre-link");
+  if (have_c)
+    return;
+
+  u8 *lto_options = "-xsan-lto=post-link";
+  for (u32 i = 0; i + 1 < cc_par_cnt; i++) {
+    if (strcmp(cc_params[i], "-mllvm") ||
+        OPT_MATCH(cc_params[i + 1], "-xsan-lto="))
+      continue;
+    lto_options = alloc_printf("%s %s", lto_options, cc_params[++i]);
+  }
+  setenv(XSAN_LTO_OPTIONS_ENV, lto_options, 1);
+
+  cc_params[cc_par_cnt++] = "-Xlinker";
+  cc_params[cc_par_cnt++] =
+      alloc_printf("--load-pass-plugin=%s", get_pass_plugin(sanTy));
+  if (frontend_opt.lto == LTOK_Full || frontend_opt.LTOOptLevel == 0) {
+    cc_params[cc_par_cnt++] = "-Xlinker";
+    cc_params[cc_par_cnt++] = alloc_printf(
+        "--lto-newpm-passes=%s<O%u>,xsan-lto<O%u>",
+        frontend_opt.lto == LTOK_Full ? "lto" : "thinlto",
+        frontend_opt.LTOOptLevel, frontend_opt.LTOOptLevel);
+  }
+}
+
 /* Copy argv to cc_params, making the necessary edits. */
 static void edit_params(u32 argc, const char **argv) {
   /// TODO:
@@ -515,8 +577,19 @@ static void edit_params(u32 argc, const char **argv) {
       partial_linking = 1;
     else if (!strcmp(cur, "-c"))
       have_c = 1;
-    else if (!strncmp(cur, "-O", 2))
+    else if (!strncmp(cur, "-O", 2)) {
       have_o = 1;
+      // As clang passes it to the linker: -O and -Og are -O1, -Os and -Oz
+      // are -O2, and -Ofast and -O4 are -O3.
+      if (cur[2] >= '0' && cur[2] <= '3')
+        frontend_opt.LTOOptLevel = cur[2] - '0';
+      else if (!strcmp(cur, "-Ofast") || !strcmp(cur, "-O4"))
+        frontend_opt.LTOOptLevel = 3;
+      else if (!strcmp(cur, "-Os") || !strcmp(cur, "-Oz"))
+        frontend_opt.LTOOptLevel = 2;
+      else
+        frontend_opt.LTOOptLevel = 1;
+    }
     else if (!strncmp(cur, "-funroll-loops", 14))
       have_unroll = 1;
     else {
@@ -536,6 +609,24 @@ static void edit_params(u32 argc, const char **argv) {
         continue;
       })
 
+      OPT_EQ_AND_THEN(cur, "-flto", {
+        frontend_opt.lto = LTOK_Full;
+        continue;
+      })
+      OPT_EQ_AND_THEN(cur, "-fno-lto", {
+        frontend_opt.lto = LTOK_None;
+        continue;
+      })
+      // -flto=full|thin|auto|jobserver, all but thin are full LTO.
+      OPT_GET_VAL_AND_THEN(cur, "-flto", {
+        frontend_opt.lto = strcmp(val, "thin") ? LTOK_Full : LTOK_Thin;
+        continue;
+      })
+      OPT_GET_VAL_AND_THEN(cur, "-fthinlto-index", {
+        frontend_opt.ThinLTOBackend = 1;
+        continue;
+      })
+
       // For ASan's global gc option.
       // Search "-asan-globals-gc=0" in this file for details.
       OPT_EQ_AND_THEN(cur, "-no-integrated-as", {
@@ -626,8 +717,10 @@ static void edit_params(u32 argc, const char **argv) {
     cc_params[cc_par_cnt++] = cur;
   }
 
-  if (!only_lib)
+  if (!only_lib) {
     add_pass_options(xsanTy);
+    add_lto_options(xsanTy, have_c);
+  }
 
   if (getenv("X_HARDEN")) {
 
@@ -0,0 +1,112 @@
+//===-- xsan_platform_aarch64_39.h: Derived by hand -----------------------===//
+//
+// Platform: MappingAarch64_39
+//
+// NOTE: This layout was NOT found by the SMT solver, since z3 was unavailable
+// when it was added. It was derived by hand, then checked against the
+// constraints of gen_mapping_via_z3.py driven by the fixed values, whose
+// header emitter printed the formulas below. Once z3 is available, prefer to
+// regenerate it with
+//
+// ./gen_mapping_via_z3.py --output=header --platform=aarch64_39
+//
+//===----------------------------------------------------------------------===/
+
+#pragma once
+
+/*
+C/C++ on MappingAarch64_39 Memory Layout:
+
+Complete Memory Layout (sorted by address):
+--------------------------------------------------------------------------------
+000000000000 - 0000fffff000: LoApp (for ASan) (4.00 GB)
+000000000000 - 000100000000: LoApp (4 GB)
+000100000000 - 001000000000: - gap (60 GB)
+001000000000 - 001200000000: -- ASan Shadow (LoApp) (8 GB)
+001200000000 - 001400000000: - gap (8 GB)
+001400000000 - 002000000000: -- ASan Shadow (Rest) (48 GB)
+002000000000 - 002200000000: -- TSan Shadow (LoApp) (8 GB)
+002200000000 - 002a00000000: -- TSan Shadow (Heap) (32 GB)
+002a00000000 - 002c00000000: -- TSan Shadow (MidApp) (8 GB)
+002c00000000 - 003000000000: -- TSan Shadow (HiApp) (16 GB)
+003000000000 - 003080000000: -- TSan Meta (LoApp) (2 GB)
+003080000000 - 003280000000: -- TSan Meta (Heap) (8 GB)
+003280000000 - 003300000000: -- TSan Meta (MidApp) (2 GB)
+003300000000 - 003400000000: -- TSan Meta (HiApp) (4 GB)
+003400000000 - 005500000000: - gap (132 GB)
+005500000000 - 005600000000: MidApp (4 GB)
+005600000000 - 007900000000: - gap (140 GB)
+007900000000 - 007d00000000: Heap (16 GB)
+007d00000000 - 007e00000000: - gap (4 GB)
+007e00000000 - 008000000000: HiApp (8 GB)
+
+*/
+struct MappingAarch64_39 {
+  static constexpr const uintptr kHeapMemBeg = 0x0079'0000'0000ull;
+  static constexpr const uintptr kHeapMemEnd = 0x007d'0000'0000ull;
+  static constexpr const uintptr kLoAppMemBeg = 0x0000'0000'0000ull;
+  static constexpr const uintptr kLoAppMemEnd = 0x0001'0000'0000ull;
+  // Used only for ASan's shadow calculation
+  static constexpr const uintptr kAsanLoAppMemEnd = 0x0000'ffff'f000ull;
+  static constexpr const uintptr kMidAppMemBeg = 0x0055'0000'0000ull;
+  static constexpr const uintptr kMidAppMemEnd = 0x0056'0000'0000ull;
+  static constexpr const uintptr kHiAppMemBeg = 0x007e'0000'0000ull;
+  static constexpr const uintptr kHiAppMemEnd = 0x0080'0000'0000ull;
+  static constexpr const uintptr kVdsoBeg = 0x007f'0000'0000ull;
+
+  // ASan Parameters:
+  static constexpr const uintptr kAsanShadowOffset = 0x0010'0000'0000ull;
+  static constexpr const uintptr kAsanShadowScale = 3;
+
+  // TSan Parameters:
+  static constexpr const uintptr kTsanShadowXor = 0x0000'0000'0000ull;
+  static constexpr const uintptr kTsanShadowAdd = 0x0020'0000'0000ull;
+  static constexpr const uintptr kTsanShadowMsk = 0x0078'0000'0000ull;
+  static constexpr const uintptr kTsanMetaShadowBeg = 0x0030'0000'0000ull;
+  static constexpr const uintptr kTsanMetaShadowEnd = 0x0034'0000'0000ull;
+  static constexpr const uintptr kTsanShadowBeg = 0x0020'0000'0000ull;
+  static constexpr const uintptr kTsanShadowEnd = 0x0030'0000'0000ull;
+
+  // Shadow Formulas:
+  static constexpr bool kFusedShadowBase = false;
+  static constexpr uintptr AsanMemToShadow(uintptr p) {
+    return (p >> kAsanShadowScale) + kAsanShadowOffset;
+  }
+  static constexpr uintptr TsanMemToShadow(uintptr p) {
+    return ((p & ~(kTsanShadowMsk | 7)) ^ kTsanShadowXor) * 2 + kTsanShadowAdd;
+  }
+  static constexpr uintptr TsanMemToMeta(uintptr p) {
+    return (p & ~(kTsanShadowMsk | 7)) / 8 * 4 | kTsanMetaShadowBeg;
+  }
+
+  // All Memory Regions to Map (just for reference as sanitizer might change the
+  // mapping dynamically)
+  static constexpr const MemRegion kRegions[] = {
+      {0x0000'0000'0000ull, 0x0000'ffff'f000ull, RegionType::App,
+       "LoApp (for ASan)"},
+      {0x0000'0000'0000ull, 0x0001'0000'0000ull, RegionType::App, "LoApp"},
+      {0x0010'0000'0000ull, 0x0012'0000'0000ull, RegionType::Shadow,
+       "ASan Shadow (LoApp)"},
+      {0x0014'0000'0000ull, 0x0020'0000'0000ull, RegionType::Shadow,
+       "ASan Shadow (Rest)"},
+      {0x0020'0000'0000ull, 0x0022'0000'0000ull, RegionType::Shadow,
+       "TSan Shadow (LoApp)"},
+      {0x0022'0000'0000ull, 0x002a'0000'0000ull, RegionType::Shadow,
+       "TSan Shadow (Heap)"},
+      {0x002a'0000'0000ull, 0x002c'0000'0000ull, RegionType::Shadow,
+       "TSan Shadow (MidApp)"},
+      {0x002c'0000'0000ull, 0x0030'0000'0000ull, RegionType::Shadow,
+       "TSan Shadow (HiApp)"},
+      {0x0030'0000'0000ull, 0x0030'8000'0000ull, RegionType::Shadow,
+       "TSan Meta (LoApp)"},
+      {0x0030'8000'0000ull, 0x0032'8000'0000ull, RegionType::Shadow,
+       "TSan Meta (Heap)"},
+      {0x0032'8000'0000ull, 0x0033'0000'0000ull, RegionType::Shadow,
+       "TSan Meta (MidApp)"},
+      {0x0033'0000'0000ull, 0x0034'0000'0000ull, RegionType::Shadow,
+       "TSan Meta (HiApp)"},
+      {0x0055'0000'0000ull, 0x0056'0000'0000ull, RegionType::App, "MidApp"},
+      {0x0079'0000'0000ull, 0x007d'0000'0000ull, RegionType::App, "Heap"},
+      {0x007e'0000'0000ull, 0x0080'0000'0000ull, RegionType::App, "HiApp"},
+  };
+};
@@ -0,0 +1,117 @@
+//===-- xsan_platform_aarch64_42.h: Derived by hand -----------------------===//
+//
+// Platform: MappingAarch64_42
+//
+// NOTE: This layout was NOT found by the SMT solver, since z3 was unavailable
+// when it was added. It was derived by hand, then checked against the
+// constraints of gen_mapping_via_z3.py driven by the fixed values, whose
+// header emitter printed the formulas below. Once z3 is available, prefer to
+// regenerate it with
+//
+// ./gen_mapping_via_z3.py --output=header --platform=aarch64_42
+//
+//===----------------------------------------------------------------------===/
+
+#pragma once
+
+/*
+C/C++ on MappingAarch64_42 Memory Layout:
+
+Complete Memory Layout (sorted by address):
+--------------------------------------------------------------------------------
+000000000000 - 000ffffff000: LoApp (for ASan) (64.00 GB)
+000000000000 - 001000000000: LoApp (64 GB)
+001000000000 - 001200000000: -- ASan Shadow (LoApp) (8 GB)
+001200000000 - 002200000000: - gap (64 GB)
+002200000000 - 009000000000: -- ASan Shadow (Rest) (440 GB)
+009000000000 - 010000000000: - gap (448 GB)
+010000000000 - 012000000000: -- TSan Shadow (LoApp) (128 GB)
+012000000000 - 014000000000: -- TSan Shadow (Heap) (128 GB)
+014000000000 - 015400000000: - gap (80 GB)
+015400000000 - 015600000000: -- TSan Shadow (MidApp) (8 GB)
+015600000000 - 016000000000: - gap (40 GB)
+016000000000 - 018000000000: -- TSan Shadow (HiApp) (128 GB)
+018000000000 - 020000000000: - gap (512 GB)
+020000000000 - 020800000000: -- TSan Meta (LoApp) (32 GB)
+020800000000 - 021000000000: -- TSan Meta (Heap) (32 GB)
+021000000000 - 021500000000: - gap (20 GB)
+021500000000 - 021580000000: -- TSan Meta (MidApp) (2 GB)
+021580000000 - 021800000000: - gap (10 GB)
+021800000000 - 022000000000: -- TSan Meta (HiApp) (32 GB)
+022000000000 - 02aa00000000: - gap (552 GB)
+02aa00000000 - 02ab00000000: MidApp (4 GB)
+02ab00000000 - 03d000000000: - gap (1.14 TB)
+03d000000000 - 03e000000000: Heap (64 GB)
+03e000000000 - 03f000000000: - gap (64 GB)
+03f000000000 - 040000000000: HiApp (64 GB)
+
+*/
+struct MappingAarch64_42 {
+  static constexpr const uintptr kHeapMemBeg = 0x03d0'0000'0000ull;
+  static constexpr const uintptr kHeapMemEnd = 0x03e0'0000'0000ull;
+  static constexpr const uintptr kLoAppMemBeg = 0x0000'0000'0000ull;
+  static constexpr const uintptr kLoAppMemEnd = 0x0010'0000'0000ull;
+  // Used only for ASan's shadow calculation
+  static constexpr const uintptr kAsanLoAppMemEnd = 0x000f'ffff'f000ull;
+  static constexpr const uintptr kMidAppMemBeg = 0x02aa'0000'0000ull;
+  static constexpr const uintptr kMidAppMemEnd = 0x02ab'0000'0000ull;
+  static constexpr const uintptr kHiAppMemBeg = 0x03f0'0000'0000ull;
+  static constexpr const uintptr kHiAppMemEnd = 0x0400'0000'0000ull;
+  static constexpr const uintptr kVdsoBeg = 0x037f'0000'0000ull;
+
+  // ASan Parameters:
+  static constexpr const uintptr kAsanShadowOffset = 0x0010'0000'0000ull;
+  static constexpr const uintptr kAsanShadowScale = 3;
+
+  // TSan Parameters:
+  static constexpr const uintptr kTsanShadowXor = 0x0000'0000'0000ull;
+  static constexpr const uintptr kTsanShadowAdd = 0x0100'0000'0000ull;
+  static constexpr const uintptr kTsanShadowMsk = 0x03c0'0000'0000ull;
+  static constexpr const uintptr kTsanMetaShadowBeg = 0x0200'0000'0000ull;
+  static constexpr const uintptr kTsanMetaShadowEnd = 0x0220'0000'0000ull;
+  static constexpr const uintptr kTsanShadowBeg = 0x0100'0000'0000ull;
+  static constexpr const uintptr kTsanShadowEnd = 0x0180'0000'0000ull;
+
+  // Shadow Formulas:
+  static constexpr bool kFusedShadowBase = false;
+  static constexpr uintptr AsanMemToShadow(uintptr p) {
+    return (p >> kAsanShadowScale) + kAsanShadowOffset;
+  }
+  static constexpr uintptr TsanMemToShadow(uintptr p) {
+    return ((p & ~(kTsanShadowMsk | 7)) ^ kTsanShadowXor) * 2 + kTsanShadowAdd;
+  }
+  static constexpr uintptr TsanMemToMeta(uintptr p) {
+    return (p & ~(kTsanShadowMsk | 7)) / 8 * 4 | kTsanMetaShadowBeg;
+  }
+
+  // All Memory Regions to Map (just for reference as sanitizer might change the
+  // mapping dynamically)
+  static constexpr const MemRegion kRegions[] = {
+      {0x0000'0000'0000ull, 0x000f'ffff'f000ull, RegionType::App,
+       "LoApp (for ASan)"},
+      {0x0000'0000'0000ull, 0x0010'0000'0000ull, RegionType::App, "LoApp"},
+      {0x0010'0000'0000ull, 0x0012'0000'0000ull, RegionType::Shadow,
+       "ASan Shadow (LoApp)"},
+      {0x0022'0000'0000ull, 0x0090'0000'0000ull, RegionType::Shadow,
+       "ASan Shadow (Rest)"},
+      {0x0100'0000'0000ull, 0x0120'0000'0000ull, RegionType::Shadow,
+       "TSan Shadow (LoApp)"},
+      {0x0120'0000'0000ull, 0x0140'0000'0000ull, RegionType::Shadow,
+       "TSan Shadow (Heap)"},
+      {0x0154'0000'0000ull, 0x0156'0000'0000ull, RegionType::Shadow,
+       "TSan Shadow (MidApp)"},
+      {0x0160'0000'0000ull, 0x0180'0000'0000ull, RegionType::Shadow,
+       "TSan Shadow (HiApp)"},
+      {0x0200'0000'0000ull, 0x0208'0000'0000ull, RegionType::Shadow,
+       "TSan Meta (LoApp)"},
+      {0x0208'0000'0000ull, 0x0210'0000'0000ull, RegionType::Shadow,
+       "TSan Meta (Heap)"},
+      {0x0215'0000'0000ull, 0x0215'8000'0000ull, RegionType::Shadow,
+       "TSan Meta (MidApp)"},
+      {0x0218'0000'0000ull, 0x0220'0000'0000ull, RegionType::Shadow,
+       "TSan Meta (HiApp)"},
+      {0x02aa'0000'0000ull, 0x02ab'0000'0000ull, RegionType::App, "MidApp"},
+      {0x03d0'0000'0000ull, 0x03e0'0000'0000ull, RegionType::App, "Heap"},
+      {0x03f0'0000'0000ull, 0x0400'0000'0000ull, RegionType::App, "HiApp"},
+  };
+};
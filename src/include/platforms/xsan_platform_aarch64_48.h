@@ -93,6 +93,30 @@ struct MappingAarch64_48 {
   static constexpr const uintptr kTsanShadowBeg = 0xaf00'0000'0000ull;
   static constexpr const uintptr kTsanShadowEnd = 0xcf00'0000'0000ull;
 
+  // Shadow Formulas:
+  // MSan's and TSan's formulas share ShadowBase(); TSan masks off
+  // the bits of kMSanShadowXor.
+  static constexpr bool kFusedShadowBase = true;
+  static constexpr uintptr ShadowBase(uintptr p) {
+    return p ^ kMSanShadowXor;
+  }
+  static constexpr uintptr AsanMemToShadow(uintptr p) {
+    return (p >> kAsanShadowScale) + kAsanShadowOffset;
+  }
+  static constexpr uintptr MSanMemToShadow(uintptr p) {
+    return ShadowBase(p);
+  }
+  static constexpr uintptr MSanMemToOrigin(uintptr p) {
+    return ShadowBase(p) + kMSanShadowAdd;
+  }
+  static constexpr uintptr TsanMemToShadow(uintptr p) {
+    return (ShadowBase(p) & ~(kTsanShadowMsk | 7)) * 2 + kTsanShadowAdd;
+  }
+  static constexpr uintptr TsanMemToMeta(uintptr p) {
+    return (ShadowBase(p) & ~(kTsanShadowMsk | 7)) / 8 * 4 |
+           kTsanMetaShadowBeg;
+  }
+
   // All Memory Regions to Map (just for reference as sanitizer might change the
   // mapping dynamically)
   static constexpr const MemRegion kRegions[] = {
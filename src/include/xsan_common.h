@@ -29,6 +29,11 @@ enum SanitizerType {
 
 enum ObjectFormatType { MachO, COFF, ELF, UnknownObjectFormat };
 
+/* The linker parses -mllvm options before loading XSan's pass plugin, so the
+   compiler wrapper passes the options of the link-time instrumentation through
+   this environment variable instead. */
+#define XSAN_LTO_OPTIONS_ENV "XSAN_LTO_OPTIONS"
+
 #define ERR_MSG_4_ORIG_PASS                                                    \
   "The original sanitizer pass is incompatible with other sanitizers, "        \
   "and its memory mappings differ under XSan;\n"                               \
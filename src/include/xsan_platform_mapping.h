@@ -40,6 +40,8 @@ struct MemRegion {
   const char *desc;
 };
 
+#include "platforms/xsan_platform_aarch64_39.h"
+#include "platforms/xsan_platform_aarch64_42.h"
 #include "platforms/xsan_platform_aarch64_48.h"
 #include "platforms/xsan_platform_x64_48.h"
 
@@ -59,10 +61,10 @@ struct MemRegion {
 using XsanMapping = MappingX64_48;
 #  elif defined(__aarch64__)
 
-/// TODO: adapt to dynamic mapping selection adhering to TSan, as
-/// the VMA size in aarch64 could be dynamic changed to 39, 42, 48.
-/// However, MSan does not support aarch64_39 and aarch64_42, so we
-/// simply use aarch64_48 for now.
+/// The default mapping, which is the one the instrumentation is built for.
+/// The runtime selects MappingAarch64_39/42 by the VMA size detected at
+/// startup (see SelectMapping), except for MSan, which only supports
+/// aarch64_48.
 using XsanMapping = MappingAarch64_48;
 
 #  elif defined(__powerpc64__)
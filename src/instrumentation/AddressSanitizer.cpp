@@ -94,6 +94,7 @@
 #include "PassRegistry.h"
 #include "Utils/MetaDataUtils.h"
 #include "Utils/Options.h"
+#include "xsan_platform_mapping.h"
 
 using namespace llvm;
 
@@ -129,6 +130,15 @@ static const uint64_t kEmscriptenShadowOffset = 0;
 // The shadow memory space is dynamically allocated.
 static const uint64_t kWindowsShadowOffset64 = kDynamicShadowSentinel;
 
+// The runtime maps ASan's shadow with the generated XSan formulas.
+static_assert(__xsan::MappingX64_48::AsanMemToShadow(0) ==
+                  (kSmallX86_64ShadowOffsetBase &
+                   (kSmallX86_64ShadowOffsetAlignMask << kDefaultShadowScale)),
+              "ASan's x86_64 shadow offset diverges from XSan's mapping");
+static_assert(__xsan::MappingAarch64_48::AsanMemToShadow(0) ==
+                  kAArch64_ShadowOffset64,
+              "ASan's aarch64 shadow offset diverges from XSan's mapping");
+
 static const size_t kMinStackMallocSize = 1 << 6;   // 64B
 static const size_t kMaxStackMallocSize = 1 << 16;  // 64K
 static const uintptr_t kCurrentStackFrameMagic = 0x41B58AB3;
@@ -3789,6 +3799,11 @@ bool XsanAddressSanitizer::collectTargetsToIntrument(
       // Skip instructions inserted by another instrumentation.
       if (Inst.hasMetadata(LLVMContext::MD_nosanitize))
         continue;
+      // Skip MOPs checked by XSan itself, or whose checks are covered by
+      // others, as decided by MopIR, or by the validation of a versioned loop.
+      if (__xsan::DelegateToXSan::is(Inst) ||
+          __xsan::MopCheckElided::is(Inst) || __xsan::LoopVersioned::is(Inst))
+        continue;
       SmallVector<InterestingMemoryOperand, 1> InterestingOperands;
       getInterestingMemoryOperands(&Inst, InterestingOperands);
 
@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "ActiveMopAnalysis.h"
+#include "../Utils/ValueUtils.h"
 
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/PostOrderIterator.h"
@@ -44,10 +45,16 @@ static bool isClobberingCall(const Instruction *Inst,
   if (IgnoreNoSanitized && Inst->hasMetadata(LLVMContext::MD_nosanitize))
     return false;
 
+  // A call that may not return or may unwind leaves the later MOPs unexecuted,
+  // as isMopBarrier requires.
+  const auto &CB = *cast<CallBase>(Inst);
+  if (!CB.willReturn() || !CB.doesNotThrow())
+    return true;
+
   if (!Inst->mayWriteToMemory())
     return false;
 
-  return true;
+  return mayFreeOrSynchronize(CB);
 }
 
 
@@ -0,0 +1,171 @@
+#include "CheckedArgSummary.h"
+#include "../Utils/Options.h"
+#include "../Utils/Statistics.h"
+#include "../Utils/ValueUtils.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/InlineAsm.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+
+#define DEBUG_TYPE "xsan-checked-args"
+
+using namespace llvm;
+
+namespace __xsan {
+
+XSAN_STATISTIC(NumSummarizedFuncs,
+               "Number of functions checking their arguments on every call");
+XSAN_STATISTIC(NumCheckedArgAccesses,
+               "Number of argument ranges checked on every call");
+
+/// Whether all the enabled sub-sanitizers check the MOPs of F, in the
+/// definition that is executed at runtime.
+static bool isSummarizable(const Function &F) {
+  using namespace options;
+  if (F.isDeclaration() || !F.hasExactDefinition() ||
+      F.hasFnAttribute(Attribute::Naked) ||
+      F.hasFnAttribute(Attribute::DisableSanitizerInstrumentation))
+    return false;
+  if (!ClDisableAsan && !F.hasFnAttribute(Attribute::SanitizeAddress))
+    return false;
+  if (!ClDisableTsan && !F.hasFnAttribute(Attribute::SanitizeThread))
+    return false;
+  if (F.getName().startswith("__asan_") || F.getName().startswith("__tsan_") ||
+      F.getName().startswith("__xsan_"))
+    return false;
+  // ASan gives up the functions with some inline assembly.
+  for (const BasicBlock &BB : F)
+    for (const Instruction &I : BB)
+      if (const auto *CB = dyn_cast<CallBase>(&I))
+        if (CB->isInlineAsm())
+          return false;
+  return true;
+}
+
+/// Returns the pointer argument of F which \p Ptr is based on with a constant
+/// offset, or nullptr.
+static const Argument *getBaseArgument(const Value *Ptr, int64_t &Offset,
+                                       const DataLayout &DL) {
+  if (Ptr->getType()->getPointerAddressSpace() != 0)
+    return nullptr;
+  Offset = 0;
+  const auto *A = dyn_cast<Argument>(
+      GetPointerBaseWithConstantOffset(Ptr, Offset, DL));
+  // The callee accesses its own copy of a byval argument, which ASan may even
+  // find safe to access.
+  if (!A || A->hasPassPointeeByValueCopyAttr())
+    return nullptr;
+  return A;
+}
+
+/// Whether the sub-sanitizers check the load or store \p I as an ordinary MOP.
+static bool isCheckedMop(const Instruction &I) {
+  if (shouldSkip(I))
+    return false;
+  if (const auto *LI = dyn_cast<LoadInst>(&I)) {
+    if (!LI->isSimple())
+      return false;
+  } else if (const auto *SI = dyn_cast<StoreInst>(&I)) {
+    if (!SI->isSimple())
+      return false;
+  } else {
+    return false;
+  }
+  // TSan checks the vtable pointers in its own way.
+  if (const MDNode *Tag = I.getMetadata(LLVMContext::MD_tbaa))
+    if (Tag->isTBAAVtableAccess())
+      return false;
+  return true;
+}
+
+CheckedArgSummaries::CheckedArgSummaries(Module &M) {
+  for (const Function &F : M) {
+    ArrayRef<CheckedArgAccess> Summary = summarize(F);
+    if (!Summary.empty()) {
+      ++NumSummarizedFuncs;
+      NumCheckedArgAccesses += Summary.size();
+    }
+  }
+}
+
+ArrayRef<CheckedArgAccess>
+CheckedArgSummaries::lookup(const Function &F) const {
+  auto It = Summaries.find(&F);
+  if (It == Summaries.end())
+    return {};
+  return It->second;
+}
+
+void CheckedArgSummaries::getCheckedRanges(
+    const CallBase &CB, SmallVectorImpl<CheckedRange> &Ranges) const {
+  const Function *Callee = CB.getCalledFunction();
+  if (!Callee || CB.getFunctionType() != Callee->getFunctionType())
+    return;
+  const DataLayout &DL = CB.getModule()->getDataLayout();
+  for (const CheckedArgAccess &Access : lookup(*Callee)) {
+    int64_t Offset = 0;
+    const Value *Base = GetPointerBaseWithConstantOffset(
+        CB.getArgOperand(Access.ArgNo), Offset, DL);
+    Ranges.push_back(
+        {Base, Offset + Access.Offset, Access.Size, Access.IsWrite});
+  }
+}
+
+ArrayRef<CheckedArgAccess> CheckedArgSummaries::summarize(const Function &F) {
+  auto It = Summaries.find(&F);
+  if (It != Summaries.end())
+    return It->second;
+  if (!isSummarizable(F) || !InProgress.insert(&F).second)
+    return {};
+
+  const DataLayout &DL = F.getParent()->getDataLayout();
+  SmallVector<CheckedArgAccess, 4> Summary;
+  SmallVector<CheckedRange, 4> CalleeRanges;
+  // Walks the blocks executed on every call, until the first barrier.
+  const BasicBlock *BB = &F.getEntryBlock();
+  bool Barrier = false;
+  while (BB && !Barrier) {
+    for (const Instruction &I : *BB) {
+      int64_t Offset = 0;
+      if (isCheckedMop(I)) {
+        Type *Ty = isa<LoadInst>(I)
+                       ? I.getType()
+                       : cast<StoreInst>(I).getValueOperand()->getType();
+        TypeSize Size = DL.getTypeStoreSize(Ty);
+        const Argument *A =
+            getBaseArgument(getLoadStorePointerOperand(&I), Offset, DL);
+        if (A && !Size.isScalable())
+          Summary.push_back(
+              {A->getArgNo(), Offset, Size.getFixedSize(), isa<StoreInst>(I)});
+      } else if (const auto *CB = dyn_cast<CallBase>(&I)) {
+        // The callee checks its arguments before its first barrier, which is
+        // no earlier than the call itself.
+        const Function *Callee = CB->getCalledFunction();
+        if (Callee && !Callee->isIntrinsic() && !isNoSanitize(I)) {
+          summarize(*Callee);
+          CalleeRanges.clear();
+          getCheckedRanges(*CB, CalleeRanges);
+          for (const CheckedRange &R : CalleeRanges) {
+            const auto *A = dyn_cast<Argument>(R.Base);
+            if (A && !A->hasPassPointeeByValueCopyAttr() &&
+                A->getType()->getPointerAddressSpace() == 0)
+              Summary.push_back({A->getArgNo(), R.Offset, R.Size, R.IsWrite});
+          }
+        }
+      }
+      if (isMopBarrier(I)) {
+        Barrier = true;
+        break;
+      }
+    }
+    const BasicBlock *Succ = BB->getSingleSuccessor();
+    BB = Succ && Succ->getSinglePredecessor() == BB ? Succ : nullptr;
+  }
+
+  InProgress.erase(&F);
+  if (Summary.empty())
+    return {};
+  return Summaries[&F] = std::move(Summary);
+}
+
+} // namespace __xsan
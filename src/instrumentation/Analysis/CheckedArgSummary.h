@@ -0,0 +1,64 @@
+#pragma once
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/IR/Module.h"
+
+namespace __xsan {
+using namespace llvm;
+
+/// A range of a pointer argument which the callee checks on every call, before
+/// it may free memory or synchronize with other threads.
+struct CheckedArgAccess {
+  unsigned ArgNo;
+  int64_t Offset;
+  uint64_t Size;
+  bool IsWrite;
+};
+
+/// A range accessed through a pointer of the caller, i.e., Base + Offset.
+struct CheckedRange {
+  const Value *Base;
+  int64_t Offset;
+  uint64_t Size;
+  bool IsWrite;
+};
+
+/// Interprocedural summaries of the arguments already checked by the callees.
+///
+/// The summary of a function collects the loads and stores based on its
+/// pointer arguments, and the summaries of its callees, from the entry to the
+/// first MOP barrier (see isMopBarrier) along the straight-line blocks. Those
+/// accesses are checked by the sub-sanitizers on every call before any barrier,
+/// so the caller may skip the checks of the same ranges right before the call.
+///
+/// Only the functions whose definition is the one executed at runtime, i.e.,
+/// hasExactDefinition(), and instrumented by all the enabled sub-sanitizers are
+/// summarized. Under LTO, most functions are internalized and summarized.
+///
+/// The summaries are computed for the whole module before the MopIR pipeline
+/// changes any function, since its decisions keep the summarized accesses
+/// checked before the first barrier.
+class CheckedArgSummaries {
+public:
+  explicit CheckedArgSummaries(Module &M);
+
+  ArrayRef<CheckedArgAccess> lookup(const Function &F) const;
+
+  /// The ranges of the caller's pointers checked by the callee of \p CB.
+  void getCheckedRanges(const CallBase &CB,
+                        SmallVectorImpl<CheckedRange> &Ranges) const;
+
+private:
+  ArrayRef<CheckedArgAccess> summarize(const Function &F);
+
+  DenseMap<const Function *, SmallVector<CheckedArgAccess, 4>> Summaries;
+  /// Functions being summarized, whose recursive calls are not summarized.
+  SmallPtrSet<const Function *, 8> InProgress;
+};
+
+} // namespace __xsan
@@ -1,14 +1,15 @@
 #include "MopRecurrenceReducer.h"
 #include "../Utils/Logging.h"
 #include "../Utils/Options.h"
+#include "../Utils/Statistics.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/GraphTraits.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/ScopedHashTable.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
-#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/LoopInfo.h"
@@ -17,6 +18,8 @@
 #include "llvm/Analysis/MemorySSA.h"
 #include "llvm/Analysis/MustExecute.h"
 #include "llvm/Analysis/PostDominators.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/Function.h"
@@ -26,6 +29,7 @@
 #include "llvm/IR/Operator.h"
 #include "llvm/IR/PassManager.h"
 #include <array>
+#include <memory>
 #include <optional>
 #include <type_traits>
 
@@ -33,7 +37,13 @@ using namespace llvm;
 
 #define DEBUG_TYPE "xsan-recurrence-reducer"
 
-STATISTIC(NumRecurentChecks, "Number of recurent checks reduced.");
+XSAN_STATISTIC(NumReccMops, "Number of MOPs considered for recurring checks");
+XSAN_STATISTIC(NumRecurentChecks, "Number of recurent checks reduced");
+XSAN_STATISTIC(NumReccPairs, "Number of pairs of MOPs compared");
+XSAN_STATISTIC(NumReccBudgetExhausted,
+               "Number of functions exceeding -xsan-reduce-rec-budget");
+XSAN_STATISTIC(ReccReduceMicros,
+               "Time spent reducing recurring checks (microseconds)");
 
 namespace __xsan {
 
@@ -435,47 +445,162 @@ struct MOPState {
   satisfy the following conditions, the corresponding check for MOP2 is
   duplicated.
     - Contains(range1, range2), considering aliases.
-    - MOP1 dom MOP2 || MOP1 pdom MOP2
     - (optional) isWrite1 || (isWrite1 == isWrite2)
-  Return the FromI if recurring, otherwise, return nullptr.
+  The caller has established that MOP1 dom MOP2 || MOP1 pdom MOP2.
   */
-  const Instruction *isMopCheckRecurring(const MemoryOperation &KillingMop,
-                                         const MemoryOperation &DeadMop,
-                                         bool WriteSensitive = true) {
-    const Instruction *KillingI = KillingMop.Inst;
-    const Instruction *DeadI = DeadMop.Inst;
-    if (!isInterestingMop(*KillingI, true) || !isInterestingMop(*DeadI, true)) {
-      return nullptr;
-    }
-
+  bool isMopCheckCovering(const MemoryOperation &KillingMop,
+                          const MemoryOperation &DeadMop,
+                          bool WriteSensitive = true) {
     // (optional) isWrite1 || (isWrite1 == isWrite2)
     if (WriteSensitive && !KillingMop.isWrite() &&
         KillingMop.isWrite() != DeadMop.isWrite()) {
-      return nullptr;
-    }
-
-    const MemoryLocation &KillingLoc = KillingMop.Loc;
-    const MemoryLocation &DeadLoc = DeadMop.Loc;
-
-    const Instruction *FromI = nullptr;
-    /// MOP1 dom MOP2 || MOP1 pdom MOP2
-    if (DT.dominates(KillingI, DeadI)) {
-      FromI = KillingI;
-    } else if (PDT.dominates(KillingI, DeadI)) {
-      FromI = DeadI;
-    } else {
-      return nullptr;
+      return false;
     }
 
     // Contains(range1, range2), considering aliases.
     int64_t KillingOff, DeadOff;
-    if (!isAccessRangeContains(KillingMop.Inst, DeadMop.Inst, KillingMop.Loc,
-                               DeadMop.Loc, KillingOff, DeadOff)) {
-      return nullptr;
+    return isAccessRangeContains(KillingMop.Inst, DeadMop.Inst, KillingMop.Loc,
+                                 DeadMop.Loc, KillingOff, DeadOff);
+  }
+};
+
+/// Finds the edges of the recurring graph without comparing every pair of
+/// MOPs, which does not scale to the huge functions of generated code.
+///
+/// A check can only cover another one accessing the same object, so MOPs are
+/// first bucketed by their underlying object. The dominator tree is then
+/// walked with a scoped table of the MOPs available in each bucket, like
+/// EarlyCSE does, so that a MOP is only compared to the MOPs of its bucket
+/// dominating it. The post-dominator tree is walked likewise to find the
+/// post-dominating ones. The pairs compared in a function are bounded by
+/// -xsan-reduce-rec-budget, after which the remaining MOPs keep their checks.
+class CoverEdgeCollector {
+  using DomTreeNode = DomTreeNodeBase<BasicBlock>;
+  /// Bucket -> index of the available MOPs, the innermost first.
+  using AvailableTable = ScopedHashTable<const Value *, unsigned>;
+  using AvailableScope = AvailableTable::ScopeTy;
+
+public:
+  CoverEdgeCollector(MOPState &State, FunctionAnalysisManager &FAM,
+                     ArrayRef<MemoryOperation> Mops, bool WriteSensitive)
+      : State(State), FAM(FAM), Mops(Mops), WriteSensitive(WriteSensitive),
+        Budget(options::opt::ClReccReduceBudget) {
+    for (unsigned Idx = 0; Idx < Mops.size(); Idx++) {
+      Buckets.push_back(getBucket(Mops[Idx]));
+      MopIndex[Mops[Idx].Inst] = Idx;
+    }
+    // Order the MOPs of each block as they are executed.
+    for (const MemoryOperation &Mop : Mops) {
+      const BasicBlock *BB = Mop.Inst->getParent();
+      auto [It, Inserted] = BlockMops.try_emplace(BB);
+      if (!Inserted)
+        continue;
+      for (const Instruction &I : *BB) {
+        auto IdxIt = MopIndex.find(&I);
+        if (IdxIt != MopIndex.end())
+          It->second.push_back(IdxIt->second);
+      }
+    }
+  }
+
+  void collect(SmallVectorImpl<Edge> &Edges) {
+    walk</*IsPostDom=*/false>(State.DT.getRootNode(), Edges);
+    walk</*IsPostDom=*/true>(State.PDT.getRootNode(), Edges);
+  }
+
+  bool budgetExhausted() const { return Budget == 0; }
+  uint64_t pairsCompared() const { return Compared; }
+
+private:
+  const Value *getBucket(const MemoryOperation &Mop) {
+    const Value *Ptr = Mop.Loc.Ptr->stripPointerCasts();
+    const Value *Obj = getUnderlyingObject(Ptr);
+    // A pointer induction variable or a select of pointers is no object by
+    // itself, but SCEV may still find the base pointer it is derived from.
+    if (!isa<PHINode>(Obj) && !isa<SelectInst>(Obj))
+      return Obj;
+    if (!SE)
+      SE = &FAM.getResult<ScalarEvolutionAnalysis>(State.F);
+    const SCEV *Base =
+        SE->getPointerBase(SE->getSCEV(const_cast<Value *>(Ptr)));
+    if (const auto *U = dyn_cast<SCEVUnknown>(Base))
+      return getUnderlyingObject(U->getValue());
+    return Obj;
+  }
+
+  template <bool IsPostDom>
+  void walk(const DomTreeNode *Root, SmallVectorImpl<Edge> &Edges) {
+    struct StackNode {
+      AvailableScope Scope;
+      const DomTreeNode *Node;
+      DomTreeNode::const_iterator NextChild;
+
+      StackNode(AvailableTable &Available, const DomTreeNode *Node)
+          : Scope(Available), Node(Node), NextChild(Node->begin()) {}
+    };
+
+    AvailableTable Available;
+    // The scopes must be popped in order, hence the explicit stack, which
+    // also keeps deep dominator trees from overflowing the native stack.
+    SmallVector<std::unique_ptr<StackNode>, 32> Stack;
+    Stack.push_back(std::make_unique<StackNode>(Available, Root));
+    visitBlock<IsPostDom>(Root->getBlock(), Available, Edges);
+    while (!Stack.empty()) {
+      StackNode &Top = *Stack.back();
+      if (Top.NextChild == Top.Node->end()) {
+        Stack.pop_back();
+        continue;
+      }
+      const DomTreeNode *Child = *Top.NextChild++;
+      Stack.push_back(std::make_unique<StackNode>(Available, Child));
+      visitBlock<IsPostDom>(Child->getBlock(), Available, Edges);
     }
+  }
 
-    return FromI;
+  template <bool IsPostDom>
+  void visitBlock(const BasicBlock *BB, AvailableTable &Available,
+                  SmallVectorImpl<Edge> &Edges) {
+    auto It = BlockMops.find(BB);
+    if (It == BlockMops.end())
+      return;
+    auto Visit = [&](unsigned DeadIdx) {
+      const Value *Bucket = Buckets[DeadIdx];
+      const MemoryOperation &DeadMop = Mops[DeadIdx];
+      for (auto KillingIt = Available.begin(Bucket);
+           KillingIt != Available.end() && Budget; ++KillingIt) {
+        const MemoryOperation &KillingMop = Mops[*KillingIt];
+        Budget--;
+        Compared++;
+        // The pairs in both relations have been found by the dominator walk.
+        if (IsPostDom && State.DT.dominates(KillingMop.Inst, DeadMop.Inst))
+          continue;
+        if (!State.isMopCheckCovering(KillingMop, DeadMop, WriteSensitive))
+          continue;
+        // MOP1 dom MOP2: From = MOP1; MOP1 pdom MOP2: From = MOP2.
+        Edges.emplace_back(KillingMop.Inst, DeadMop.Inst,
+                           IsPostDom ? DeadMop.Inst : KillingMop.Inst, false);
+      }
+      Available.insert(Bucket, DeadIdx);
+    };
+    if (IsPostDom)
+      for_each(reverse(It->second), Visit);
+    else
+      for_each(It->second, Visit);
   }
+
+  MOPState &State;
+  FunctionAnalysisManager &FAM;
+  ScalarEvolution *SE = nullptr;
+  ArrayRef<MemoryOperation> Mops;
+  const bool WriteSensitive;
+  unsigned Budget;
+  uint64_t Compared = 0;
+
+  /// The bucket of each MOP.
+  SmallVector<const Value *, 16> Buckets;
+  DenseMap<const Instruction *, unsigned> MopIndex;
+  /// The MOPs of each block, in program order.
+  DenseMap<const BasicBlock *, SmallVector<unsigned, 4>> BlockMops;
 };
 
 void RecurringGraph::fillDominatingSet(
@@ -524,38 +649,35 @@ MopRecurrenceReducer::distillRecurringChecks(
     return SmallVector<const Instruction *, 16>(Insts.begin(), Insts.end());
   }
 
-  SmallVector<Edge, 16> Edges;
-  SmallSetVector<const Instruction *, 16> CandidatesSet;
+  stats::ScopedTimer Timer(ReccReduceMicros);
+  NumReccMops += Insts.size();
 
   MOPState State(F, FAM);
 
-  bool WriteSensitive = IsTsan;
+  // Non-interesting MOPs are never recurring, and keep their checks.
+  SmallVector<MemoryOperation, 16> Mops;
+  SmallPtrSet<const Instruction *, 16> Seen;
+  for (const Instruction *I : Insts) {
+    if (isInterestingMop(*I, true) && Seen.insert(I).second)
+      Mops.emplace_back(I);
+  }
 
   /*
     - Contains(range1, range2), considering aliases.
     - MOP1 dom MOP2 || MOP1 pdom MOP2
     - (optional) isWrite1 || (isWrite1 == isWrite2)
   */
-  for (const Instruction *KillingI : Insts) {
-    for (const Instruction *DeadI : Insts) {
-      if (KillingI == DeadI)
-        continue;
-
-      // /// Volatile MOP's check could not have been eliminated.
-      // /// However, TSan ClDistinguishVolatile is always false, that means
-      // /// TSan does not treat volatile MOP's specially.
-      // if (DeadI->isVolatile())
-      //   continue;
-
-      const Instruction *FromI =
-          State.isMopCheckRecurring(KillingI, DeadI, WriteSensitive);
-      if (!FromI)
-        continue;
-      Edges.emplace_back(KillingI, DeadI, FromI, false);
+  SmallVector<Edge, 16> Edges;
+  CoverEdgeCollector Collector(State, FAM, Mops, /*WriteSensitive=*/IsTsan);
+  Collector.collect(Edges);
+  NumReccPairs += Collector.pairsCompared();
+  if (Collector.budgetExhausted())
+    ++NumReccBudgetExhausted;
 
-      CandidatesSet.insert(KillingI);
-      CandidatesSet.insert(DeadI);
-    }
+  SmallSetVector<const Instruction *, 16> CandidatesSet;
+  for (const Edge &E : Edges) {
+    CandidatesSet.insert(E.Killing);
+    CandidatesSet.insert(E.Dead);
   }
 
   /// Initialized with Insts with neither Killing nor Dead Mops.
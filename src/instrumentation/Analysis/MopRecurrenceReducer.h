@@ -65,6 +65,9 @@ public:
         + Loop: 1. Add the vertex hasing not been traversed from any other
                    vertex into dominating set.
                 2. Travese from any vertex in dominating set.
+
+    The edges are found by walking the (post-)dominator tree, only comparing
+    MOPs on the same underlying object, within -xsan-reduce-rec-budget pairs.
   */
   SmallVector<const Instruction *, 16>
   distillRecurringChecks(ArrayRef<const Instruction *> Insts,
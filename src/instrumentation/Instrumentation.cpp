@@ -15,6 +15,7 @@
 #include "Utils/Logging.h"
 #include "Utils/MetaDataUtils.h"
 #include "Utils/Options.h"
+#include "Utils/Statistics.h"
 #include "Utils/ValueUtils.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/MapVector.h"
@@ -52,6 +53,8 @@
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/LoopUtils.h"
 #include "llvm/Transforms/Utils/ScalarEvolutionExpander.h"
 #include <cstdint>
 #include <optional>
@@ -71,6 +74,15 @@ uint32_t NumInvChecksRelocatedDup = 0;
 uint32_t NumPeriodChecksCombined = 0;
 uint32_t NumPeriodChecksCombinedDup = 0;
 
+XSAN_STATISTIC(NumCombinedMops,
+               "Number of MOPs whose checks are combined after their loops");
+XSAN_STATISTIC(NumMultiExitCombinedMops,
+               "Number of MOPs combined on each exit of multi-exit loops");
+XSAN_STATISTIC(NumNestHoistedMops,
+               "Number of MOPs combined after the outer loops of their nests");
+XSAN_STATISTIC(NumLoopsWithBenignCalls,
+               "Number of combinable loops with calls that never free or sync");
+
 namespace {
 /// Diagnostic information for IR instrumentation reporting.
 class DiagnosticInfoInstrumentation : public DiagnosticInfo {
@@ -584,8 +596,9 @@ in `isLoadInvariantInLoop` @ LICM.cpp).
 Therefore, we just analyze the relevant store instruction to determine if it is
 possible to write to the memory location of the load instruction.
 
-CallInst is ignored, because we assume that the Loop is a simple loop without
-any calls that may write to memory.
+A combinable loop may only contain the calls that neither free memory nor
+synchronize (see isBenignCall), which are also checked against the load if they
+write to memory.
 */
 bool LoopInvariantChecker::isLoadLoopInvariant(const LoadInst *LI,
                                                const Loop *L) {
@@ -601,14 +614,19 @@ bool LoopInvariantChecker::isLoadLoopInvariant(const LoadInst *LI,
   // 3. Traverse all basic blocks within the loop to ensure no store can modify
   // the memory location of the load
   SmallVectorImpl<MemoryLocation> &StoreLocs = getStoresInLoopLazily(L);
-  if (StoreLocs.empty()) {
+  SmallVectorImpl<const CallBase *> &Calls = WritingCallsInLoop[L];
+  if (StoreLocs.empty() && Calls.empty()) {
     return true;
   }
 
   MemoryLocation LoadLoc = MemoryLocation::get(LI);
-  return all_of(StoreLocs, [&](auto &StoreLoc) {
-    return AA.alias(LoadLoc, StoreLoc) == AliasResult::NoAlias;
-  });
+  return all_of(StoreLocs,
+                [&](auto &StoreLoc) {
+                  return AA.alias(LoadLoc, StoreLoc) == AliasResult::NoAlias;
+                }) &&
+         none_of(Calls, [&](const CallBase *Call) {
+           return isModSet(AA.getModRefInfo(Call, LoadLoc));
+         });
 }
 
 SmallVectorImpl<MemoryLocation> &
@@ -618,6 +636,7 @@ LoopInvariantChecker::getStoresInLoopLazily(const Loop *L) {
     return It->second;
   }
   SmallVector<MemoryLocation, 8> Stores;
+  SmallVector<const CallBase *, 2> Calls;
   for (BasicBlock *BB : L->getBlocks()) {
     for (Instruction &I : *BB) {
       // Ignore the load instruction itself
@@ -629,9 +648,15 @@ LoopInvariantChecker::getStoresInLoopLazily(const Loop *L) {
       if (StoreInst *SI = dyn_cast<StoreInst>(&I)) {
         MemoryLocation StoreLoc = MemoryLocation::get(SI);
         Stores.push_back(StoreLoc);
+      } else if (const auto *Call = dyn_cast<CallBase>(&I)) {
+        // The calls to the sanitizers' runtime, e.g., UBSan's handlers, do
+        // not write to the user's memory.
+        if (!shouldSkip(I) && !isa<DbgInfoIntrinsic>(I))
+          Calls.push_back(Call);
       }
     }
   }
+  WritingCallsInLoop[L] = std::move(Calls);
   StoresInLoop[L] = std::move(Stores);
   return StoresInLoop[L];
 }
@@ -844,10 +869,13 @@ static Value *getCounterBoundedByTargetTy(Value *SrcVal, IntegerType *TargetTy,
   return Counter;
 }
 
-/// Calculate End based on End = Beg + Step * Counter
+/// Calculate End based on End = Beg + Step * Counter at the beginning of Exit,
+/// which is the only successor of Exiting out of the loop.
 /// Note: If MOP dominates Exiting (see @arg BeforeExiting), then Counter is
 /// the number of backedge taken counts + 1, otherwise it is the number of
 /// backedge taken counts
+/// Note: Exiting is not necessarily the only exiting block, as the backedge
+/// taken count is exactly the exit count of Exiting once the loop exits there.
 /// Note that, if Step is a negative constant, this function will adjust the
 /// access range accordingly as follows (see handleRangeWithNegativeStep):
 //  [Beg', End') = [End + |Step|, Beg + |Step|), i.e.,
@@ -863,12 +891,13 @@ static Value *getCounterBoundedByTargetTy(Value *SrcVal, IntegerType *TargetTy,
 static bool expandBegAndEnd(Loop *Loop, ScalarEvolution &SE,
                             XsanSCEVExpander &Expander, const SCEV *Start,
                             const SCEV *Step, IntegerType *CounterTy,
+                            BasicBlock *Exiting, BasicBlock *Exit,
                             bool BeforeExiting, InstrumentationIRBuilder &IRB,
                             Value *&Beg, Value *&End, Value *&StepVal) {
   // 1. Try to find an existing loop counter in the loop header (header)
   BasicBlock *Header = Loop->getHeader(),
              *Predecessor = Loop->getLoopPredecessor(),
-             *Latch = Loop->getLoopLatch(), *Exit = Loop->getUniqueExitBlock();
+             *Latch = Loop->getLoopLatch();
 
   if (!Header || !Predecessor || !Latch)
     return false; // If the loop does not have a header, it is unsafe to
@@ -906,7 +935,7 @@ static bool expandBegAndEnd(Loop *Loop, ScalarEvolution &SE,
   /// negating the sign of offset.
   bool StepIsOne = ConstStepVal && ConstStepVal->isOne();
 
-  const auto *BackedgeTakenCount = SE.getBackedgeTakenCount(Loop);
+  const auto *BackedgeTakenCount = SE.getExitCount(Loop, Exiting);
   if (!isa<SCEVCouldNotCompute>(BackedgeTakenCount)) {
     /* Try to get the loop's backedge taken count (loop invariant) via SCEV */
 
@@ -1105,12 +1134,14 @@ void LoopMopInstrumenter::collectLoopMopCandidates() {
     if (!Loop) {
       continue;
     }
-    if (!isSimpleLoop(Loop)) {
+    if (!isCombinableLoop(Loop)) {
       continue;
     }
 
     for (Instruction &Inst : BB) {
-      if (shouldSkip(Inst))
+      // The clone of a versioned loop is only checked by the other
+      // sub-sanitizers.
+      if (shouldSkip(Inst) || LoopVersioned::is(Inst))
         continue;
       // Does not consider volatile/atomic/dbginfo instructions
       if (Inst.isVolatile() || Inst.isAtomic() || isa<DbgInfoIntrinsic>(Inst))
@@ -1219,29 +1250,60 @@ void LoopMopInstrumenter::filterAndAddMops(SmallVectorImpl<LoopMop> &MOPs) {
 }
 
 bool LoopMopInstrumenter::isSimpleLoop(const Loop *Loop) {
+  /// ONE exiting block, ONE exit block
+  /// Note that, some Loop may have > 1 exit, but only 1 uniq exit, hence we
+  /// use API `getUniqueExitBlock` to get the unique exit block.
+  /// i.e., switch ... %latch { ..., %exit; ..., %exit; } has 2 exits, but only
+  /// 1 uniq exit.
+  return isCombinableLoop(Loop) && Loop->getUniqueExitBlock() &&
+         Loop->getExitingBlock();
+}
+
+/// A call is benign to the loop optimization if it never frees memory, never
+/// synchronizes with other threads, and always returns to the loop. Hence the
+/// memory checked after the loop is still alive, and no happens-before edge
+/// separates the MOPs from their combined checks.
+/// Note that LLVM 15 has no `memory(...)` attribute, so we rely on the function
+/// attributes inferred by FunctionAttrs or attached to the known library calls.
+/// Intrinsics are rejected, as lifetime markers and stackrestore end the scope
+/// of the stack objects whose checks would be moved after the loop.
+static bool isBenignCall(const CallBase &Call) {
+  return !Call.isInlineAsm() && !isa<IntrinsicInst>(Call) &&
+         Call.hasFnAttr(Attribute::NoFree) &&
+         Call.hasFnAttr(Attribute::NoSync) && Call.willReturn() &&
+         Call.doesNotThrow();
+}
+
+bool LoopMopInstrumenter::isCombinableLoop(const Loop *Loop) {
   if (!Loop)
     return false;
-  if (SimpleLoops.contains(Loop))
+  if (CombinableLoops.contains(Loop))
     return true;
   if (ComplexLoops.contains(Loop))
     return false;
 
   /// TODO: relax this condition
-  /// ONE latch, ONE predecessor, ONE header, ONE exiting block, ONE exit block
-  /// Note that, some Loop may have > 1 exit, but only 1 uniq exit, hence we
-  /// use API `getUniqueExitBlock` to get the unique exit block.
-  /// i.e., switch ... %latch { ..., %exit; ..., %exit; } has 2 exits, but only
-  /// 1 uniq exit.
+  /// ONE latch, ONE predecessor, ONE header
   if (!Loop->getHeader() || !Loop->getLoopPredecessor() ||
-      !Loop->getLoopLatch() || !Loop->getUniqueExitBlock() ||
-      !Loop->getExitingBlock()) {
+      !Loop->getLoopLatch()) {
     ComplexLoops.insert(Loop);
     return false;
   }
+  // Each exit edge might be split to place the checks, which is impossible
+  // for the unwind edges of invokes, or the edges of indirectbr/callbr.
+  SmallVector<BasicBlock *, 4> Exitings;
+  Loop->getExitingBlocks(Exitings);
+  for (const BasicBlock *Exiting : Exitings) {
+    if (!isa<BranchInst, SwitchInst>(Exiting->getTerminator())) {
+      ComplexLoops.insert(Loop);
+      return false;
+    }
+  }
 
-  // Loop that contains atomic instructions or calls is not simple.
+  // Loop that contains atomic instructions or calls is not combinable.
   // Notaly, a loop with a pure function call that does not write to
-  // memory is also considered as a simple loop.
+  // memory, or with a benign call, is also considered as combinable.
+  bool HasBenignCall = false;
   for (const BasicBlock *BB : Loop->getBlocks()) {
     for (const Instruction &I : *BB) {
       if (shouldSkip(I))
@@ -1251,16 +1313,60 @@ bool LoopMopInstrumenter::isSimpleLoop(const Loop *Loop) {
       if (isa<DbgInfoIntrinsic>(I))
         continue;
       /// TODO: should consider Atomic for ASan ?
-      if (I.isAtomic() || isa<CallBase>(&I)) {
+      const auto *Call = dyn_cast<CallBase>(&I);
+      if (I.isAtomic() || (Call && !isBenignCall(*Call))) {
         ComplexLoops.insert(Loop);
         return false;
       }
+      HasBenignCall |= Call != nullptr;
     }
   }
-  SimpleLoops.insert(Loop);
+  if (HasBenignCall)
+    ++NumLoopsWithBenignCalls;
+  CombinableLoops.insert(Loop);
   return true;
 }
 
+/// If the runs of the loop of AR access adjacent ranges through the MOP, i.e.,
+/// each run scans the range right after the one of the last run, as in
+///   for (i = 0; i < n; i++)
+///     for (j = 0; j < m; j++)
+///       a[i * m + j] = 0;
+/// where the MOP accesses {{a, +, 4 * m}<i>, +, 4}<j>, returns the AddRec of
+/// the parent loop {a, +, 4 * m}<i>, whose step is exactly the range of a run.
+/// Hence the range [a, a + 4 * m * n) is checked after the parent loop.
+const SCEVAddRecExpr *
+LoopMopInstrumenter::getRangeInParentLoop(const SCEVAddRecExpr *AR,
+                                          const BasicBlock *MopBB,
+                                          ScalarEvolution &SE) {
+  const Loop *L = AR->getLoop();
+  const Loop *Parent = L->getParentLoop();
+  const SCEV *Step = AR->getStepRecurrence(SE);
+  if (!Parent || !isSimpleLoop(L) || !isSimpleLoop(Parent) ||
+      !SE.isKnownNonNegative(Step))
+    return nullptr;
+  // L runs once in each iteration of the parent loop.
+  if (!DT.dominates(L->getHeader(), Parent->getLoopLatch()))
+    return nullptr;
+  const auto *ParentAR = dyn_cast<SCEVAddRecExpr>(AR->getStart());
+  if (!ParentAR || ParentAR->getLoop() != Parent || !ParentAR->isAffine())
+    return nullptr;
+  const SCEV *BackedgeTakenCount = SE.getBackedgeTakenCount(L);
+  if (isa<SCEVCouldNotCompute>(BackedgeTakenCount))
+    return nullptr;
+
+  // The number of times the MOP is executed in a run of L. It might be
+  // underestimated, in which case the ranges are not proven adjacent.
+  Type *IntTy = Step->getType();
+  const SCEV *Count = SE.getTruncateOrZeroExtend(BackedgeTakenCount, IntTy);
+  if (DT.dominates(MopBB, L->getExitingBlock()))
+    Count = SE.getAddExpr(Count, SE.getOne(IntTy));
+  const SCEV *RangeOfRun = SE.getMulExpr(Count, Step);
+  if (RangeOfRun != ParentAR->getStepRecurrence(SE))
+    return nullptr;
+  return ParentAR;
+}
+
 /*
    while (cond) {
       CHECK(ptr)
@@ -1277,13 +1383,14 @@ bool LoopMopInstrumenter::isSimpleLoop(const Loop *Loop) {
    }
    CHECK(ptr_init, ptr_init + loop_count * sizeof(val))
 
-Currently only targets the simplest loops, i.e.:
- 1. Single header, single predecessor, single latch, single exit
+Currently only targets the combinable loops, i.e.:
+ 1. Single header, single predecessor, single latch, with each exit checked
+    separately.
  2. Loads/stores not within branches.
  3. Canonical loops, i.e., well-formed loops.
-TODO: Perhaps we can relax these conditions in the future. For example, multiple
-exits, multiple exits, multiple latches (in which case each MOP needs to
-maintain a corresponding counter)
+TODO: Perhaps we can relax these conditions in the future. For example,
+multiple latches (in which case each MOP needs to maintain a corresponding
+counter)
  */
 bool LoopMopInstrumenter::combinePeriodicChecks(bool RangeAccessOnly) {
   bool LoopChanged = false;
@@ -1365,7 +1472,7 @@ bool LoopMopInstrumenter::combinePeriodicChecks(bool RangeAccessOnly) {
     /// relevant LOOP of the AddRec, i.e., the MOP address is an invariant of
     /// the direct parent LOOP, but changes with the outer loops.
     Loop *L = const_cast<Loop *>(AR->getLoop());
-    if (!isSimpleLoop(L)) {
+    if (!isCombinableLoop(L)) {
       continue;
     }
 
@@ -1389,57 +1496,94 @@ bool LoopMopInstrumenter::combinePeriodicChecks(bool RangeAccessOnly) {
       continue;
     }
 
-    auto *ExitBlock = L->getUniqueExitBlock();
-    auto *Exiting = L->getExitingBlock();
-
-    /* 2. Combine periodic MOPs into a single range check */
+    /* 2. Hoist the range check out of the loop nest */
+    const BasicBlock *MopBB = Inst->getParent();
+    // Only the ranges of the innermost loop of the MOP are hoisted, as the MOP
+    // might not be executed in an iteration of the loops in between.
+    if (IsRangeAccess && L == Mop.Loop &&
+        CounterTy->getBitWidth() == DL.getPointerSizeInBits()) {
+      bool Hoisted = false;
+      while (const auto *ParentAR = getRangeInParentLoop(AR, MopBB, SE)) {
+        // The range of a run of the child loop is accessed once it is entered,
+        // even if the MOP itself sits after an exit of the child loop.
+        MopBB = AR->getLoop()->getHeader();
+        AR = ParentAR;
+        Hoisted = true;
+      }
+      if (Hoisted) {
+        L = const_cast<Loop *>(AR->getLoop());
+        Step = AR->getStepRecurrence(SE);
+        ++NumNestHoistedMops;
+      }
+    }
 
-    // If dominates Exiting, need to add 1 to the counter, otherwise no need
-    // to add
-    bool IsMopBeforeExiting = DT.dominates(Inst->getParent(), Exiting);
+    /* 3. Combine periodic MOPs into a single range check on each exit */
+    // Each exit has its own check bounded by its own exit count, which is the
+    // actual backedge taken count once the loop exits there.
+    SmallVector<Loop::Edge, 4> ExitEdges, UniqueExitEdges;
+    L->getExitEdges(ExitEdges);
+    for (const Loop::Edge &Edge : ExitEdges)
+      if (!is_contained(UniqueExitEdges, Edge))
+        UniqueExitEdges.push_back(Edge);
+
+    // The MOP is left to the sub-sanitizers if any exit fails to be checked,
+    // leaving the checks on the other exits redundant but harmless.
+    bool AllExitsChecked = true;
+    for (auto [Exiting, ExitBlock] : UniqueExitEdges) {
+      // If dominates Exiting, need to add 1 to the counter, otherwise no need
+      // to add
+      bool IsMopBeforeExiting = DT.dominates(MopBB, Exiting);
 
-    // The only predecessor of exit should be the exiting block.
-    if (ExitBlock->getUniquePredecessor() != Exiting) {
-      // ExitBlock has > 1 uniq predecessors, edge Exiting->ExitBlock must be
-      // a critical edge, which requires |succ(pred)| > 1 or |pred(succ)| > 1.
+      // The only predecessor of exit should be the exiting block.
+      if (ExitBlock->getUniquePredecessor() != Exiting) {
+        // ExitBlock has > 1 uniq predecessors, edge Exiting->ExitBlock must be
+        // a critical edge, which requires |succ(pred)| > 1 or |pred(succ)| > 1.
 
-      // Update ExitBlock
-      // This optimization splits block without update PDT, causing PDT cannot
-      // be updated correctly in the following splitKnownCriticalEdge.
-      // Hence, we set PDT to nullptr here.
-      ExitBlock = splitKnownCriticalEdge(Exiting, ExitBlock, &DT, nullptr, &LI,
-                                         &MSSAU, "xsan.loop.exit");
-      LoopChanged = true;
-    }
+        // Update ExitBlock
+        // This optimization splits block without update PDT, causing PDT
+        // cannot be updated correctly in the following splitKnownCriticalEdge.
+        // Hence, we set PDT to nullptr here.
+        ExitBlock = splitKnownCriticalEdge(Exiting, ExitBlock, &DT, nullptr,
+                                           &LI, &MSSAU, "xsan.loop.exit");
+        LoopChanged = true;
+      }
 
-    InstrumentationIRBuilder IRB(&*ExitBlock->getFirstInsertionPt());
+      InstrumentationIRBuilder IRB(&*ExitBlock->getFirstInsertionPt());
 
-    const auto *Start = AR->getStart();
-    Value *Beg, *End, *StepVal;
-    if (!expandBegAndEnd(L, SE, Expander, Start, Step, CounterTy,
-                         IsMopBeforeExiting, IRB, Beg, End, StepVal)) {
-      // If failed to expand, skip.
-      continue;
-    }
+      const auto *Start = AR->getStart();
+      Value *Beg, *End, *StepVal;
+      if (!expandBegAndEnd(L, SE, Expander, Start, Step, CounterTy, Exiting,
+                           ExitBlock, IsMopBeforeExiting, IRB, Beg, End,
+                           StepVal)) {
+        // If failed to expand, skip.
+        AllExitsChecked = false;
+        break;
+      }
 
-    // instrument the Mop
-    Constant *BlockAddr =
-        getBlockAddressOfInstruction(*Mop.Mop, &DT, &LI, &MSSAU);
-    Value *PcValue = IRB.CreatePtrToInt(BlockAddr, IRB.getInt64Ty());
+      // instrument the Mop
+      Constant *BlockAddr =
+          getBlockAddressOfInstruction(*Mop.Mop, &DT, &LI, &MSSAU);
+      Value *PcValue = IRB.CreatePtrToInt(BlockAddr, IRB.getInt64Ty());
 
-    if (IsRangeAccess) {
-      // void __xsan_read_range(const void *beg, const void *end) {
-      // void __xsan_write_range(const void *beg, const void *end) {
-      IRB.CreateCall(IsWrite ? XsanRangeWrite : XsanRangeRead,
-                     {Beg, End, PcValue});
-    } else {
-      size_t Idx = countTrailingZeros(MopSize);
-      // __xsan_period_readX(const void *beg, const void *end, size_t step)
-      // __xsan_period_writeX(const void *beg, const void *end, size_t step)
-      IRB.CreateCall(IsWrite ? XsanPeriodWrite[Idx] : XsanPeriodRead[Idx],
-                     {Beg, End, StepVal, PcValue});
+      if (IsRangeAccess) {
+        // void __xsan_read_range(const void *beg, const void *end) {
+        // void __xsan_write_range(const void *beg, const void *end) {
+        IRB.CreateCall(IsWrite ? XsanRangeWrite : XsanRangeRead,
+                       {Beg, End, PcValue});
+      } else {
+        size_t Idx = countTrailingZeros(MopSize);
+        // __xsan_period_readX(const void *beg, const void *end, size_t step)
+        // __xsan_period_writeX(const void *beg, const void *end, size_t step)
+        IRB.CreateCall(IsWrite ? XsanPeriodWrite[Idx] : XsanPeriodRead[Idx],
+                       {Beg, End, StepVal, PcValue});
+      }
     }
+    if (!AllExitsChecked)
+      continue;
 
+    NumCombinedMops += 1 + DupTo.size();
+    if (UniqueExitEdges.size() > 1)
+      ++NumMultiExitCombinedMops;
     NumPeriodChecksCombinedDup += tagMopAsDelegated(Mop);
     NumPeriodChecksCombined++;
   }
@@ -1512,6 +1656,9 @@ bool LoopMopInstrumenter::relocateInvariantChecks() {
   BasicBlock *LastBB = nullptr;
   for (LoopMop &Mop : getLoopMopCandidates()) {
     auto &[Inst, Addr, L, MopSize, DupTo, InBranch, IsWrite] = Mop;
+    // The relocated check is placed on the only exit if not hoisted.
+    if (!isSimpleLoop(L))
+      continue;
     if (!LIC.isLoopInvariant(Addr, L)) {
       // Skip if Addr is not a loop invariant
       continue;
@@ -1623,4 +1770,224 @@ unsigned LoopMopInstrumenter::tagMopAsDelegated(LoopMop &Mop) {
   return Dup.size();
 }
 
+// ---------------------- Loop Versioning ---------------------------
+
+XSAN_STATISTIC(NumLoopsVersioned,
+               "Number of loops versioned by the ranges they access");
+XSAN_STATISTIC(NumVersionedMops,
+               "Number of MOPs unchecked by ASan in the versioned loops");
+
+/// Cloning doubles the code of the loop, and validating a range scans its
+/// shadow, hence only the small loops with a few ranges are versioned.
+static constexpr unsigned kMaxVersionedLoopSize = 128;
+static constexpr unsigned kMaxVersionedRanges = 4;
+
+LoopVersioningInstrumenter
+LoopVersioningInstrumenter::create(Function &F, FunctionAnalysisManager &FAM) {
+  LoopVersioningInstrumenter LVI(F, FAM);
+  return LVI;
+}
+
+LoopVersioningInstrumenter::LoopVersioningInstrumenter(
+    Function &F, FunctionAnalysisManager &FAM)
+    : F(F), FAM(FAM), LI(FAM.getResult<LoopAnalysis>(F)),
+      DT(FAM.getResult<DominatorTreeAnalysis>(F)),
+      SE(FAM.getResult<ScalarEvolutionAnalysis>(F)),
+      DL(F.getParent()->getDataLayout()) {
+  Module &M = *F.getParent();
+  LLVMContext &Ctx = M.getContext();
+  IRBuilder<> IRB(Ctx);
+
+  AttributeList Attr;
+  Attr = Attr.addFnAttribute(Ctx, Attribute::NoUnwind);
+  // int __xsan_range_is_clean(const void *beg, const void *end)
+  XsanRangeIsClean =
+      M.getOrInsertFunction("__xsan_range_is_clean", Attr, IRB.getInt32Ty(),
+                            IRB.getInt8PtrTy(), IRB.getInt8PtrTy());
+}
+
+void LoopVersioningInstrumenter::instrument() {
+  if (F.isDeclaration() || F.empty())
+    return;
+  // The clones are added to LoopInfo while versioning.
+  SmallVector<Loop *, 8> Loops;
+  for (Loop *L : LI.getLoopsInPreorder())
+    if (L->isInnermost())
+      Loops.push_back(L);
+
+  bool Changed = false;
+  SmallVector<AccessRange, kMaxVersionedRanges> Ranges;
+  for (Loop *L : Loops) {
+    if (!isVersionable(L))
+      continue;
+    Ranges.clear();
+    collectAccessRanges(L, Ranges);
+    if (Ranges.empty())
+      continue;
+    Changed |= versionLoop(L, Ranges);
+  }
+  if (Changed)
+    FAM.invalidate(F, PreservedAnalyses::none());
+}
+
+/// Besides the restrictions of LoopMopInstrumenter::isSimpleLoop, the loop
+/// must be in the simplified form with a single exit edge, and cloneable.
+bool LoopVersioningInstrumenter::isVersionable(const Loop *L) {
+  if (!L->isLoopSimplifyForm() || !L->isSafeToClone())
+    return false;
+  BasicBlock *Exiting = L->getExitingBlock();
+  BasicBlock *Exit = L->getExitBlock();
+  if (!Exiting || !Exit || Exit->getSinglePredecessor() != Exiting)
+    return false;
+  if (isa<SCEVCouldNotCompute>(SE.getBackedgeTakenCount(L)))
+    return false;
+
+  unsigned Size = 0;
+  for (const BasicBlock *BB : L->getBlocks()) {
+    Size += BB->size();
+    if (Size > kMaxVersionedLoopSize)
+      return false;
+    for (const Instruction &I : *BB) {
+      if (shouldSkip(I) || !I.mayWriteToMemory() || isa<DbgInfoIntrinsic>(I))
+        continue;
+      // A call may free or poison the validated ranges.
+      if (I.isAtomic() || isa<CallBase>(I))
+        return false;
+    }
+  }
+  return true;
+}
+
+void LoopVersioningInstrumenter::collectAccessRanges(
+    const Loop *L, SmallVectorImpl<AccessRange> &Ranges) {
+  const SCEV *BackedgeTakenCount = SE.getBackedgeTakenCount(L);
+  for (BasicBlock *BB : L->getBlocks()) {
+    for (Instruction &I : *BB) {
+      if (shouldSkip(I) || I.isVolatile() || I.isAtomic())
+        continue;
+      Value *Addr = getLoadStorePointerOperand(&I);
+      if (!Addr || Addr->getType()->getPointerAddressSpace() != 0)
+        continue;
+      TypeSize Size = DL.getTypeStoreSize(getLoadStoreType(&I));
+      if (Size.isScalable())
+        continue;
+
+      /* 1. The first and the last addresses accessed by the MOP */
+      const SCEV *Ptr = SE.getSCEV(Addr);
+      const SCEV *First = Ptr, *Last = Ptr;
+      if (!SE.isLoopInvariant(Ptr, L)) {
+        const auto *AR = dyn_cast<SCEVAddRecExpr>(Ptr);
+        if (!AR || AR->getLoop() != L || !AR->isAffine())
+          continue;
+        const auto *Step = dyn_cast<SCEVConstant>(AR->getStepRecurrence(SE));
+        if (!Step)
+          continue;
+        First = AR->getStart();
+        Last = AR->evaluateAtIteration(BackedgeTakenCount, SE);
+        if (Step->getAPInt().isNegative())
+          std::swap(First, Last);
+      }
+      Type *IntTy = SE.getEffectiveSCEVType(Ptr->getType());
+      const SCEV *End =
+          SE.getAddExpr(Last, SE.getConstant(IntTy, Size.getFixedSize()));
+
+      /* 2. Merge the ranges at constant distances, e.g., of a[i] and a[i+1] */
+      AccessRange *Merged = nullptr;
+      for (AccessRange &R : Ranges) {
+        const auto *BegDiff =
+            dyn_cast<SCEVConstant>(SE.getMinusSCEV(First, R.Beg));
+        const auto *EndDiff =
+            dyn_cast<SCEVConstant>(SE.getMinusSCEV(End, R.End));
+        if (!BegDiff || !EndDiff)
+          continue;
+        if (BegDiff->getAPInt().isNegative())
+          R.Beg = First;
+        if (EndDiff->getAPInt().isStrictlyPositive())
+          R.End = End;
+        Merged = &R;
+        break;
+      }
+      if (!Merged) {
+        // The MOPs beyond the limit are just left instrumented.
+        if (Ranges.size() == kMaxVersionedRanges)
+          continue;
+        Merged = &Ranges.emplace_back(AccessRange{First, End, {}});
+      }
+      Merged->Mops.push_back(&I);
+    }
+  }
+}
+
+bool LoopVersioningInstrumenter::versionLoop(
+    Loop *L, SmallVectorImpl<AccessRange> &Ranges) {
+  BasicBlock *CheckBB = L->getLoopPreheader();
+  BasicBlock *Exiting = L->getExitingBlock();
+  BasicBlock *Exit = L->getExitBlock();
+  Instruction *InsertPt = CheckBB->getTerminator();
+  XsanSCEVExpander Expander(SE, DL, "xsan.lver");
+  erase_if(Ranges, [&](const AccessRange &R) {
+    return !Expander.isSafeToExpandAt(R.Beg, InsertPt) ||
+           !Expander.isSafeToExpandAt(R.End, InsertPt);
+  });
+  if (Ranges.empty())
+    return false;
+
+  // The values defined in the loop then reach their users only through the
+  // PHIs of the exit block, which merge the values of both versions.
+  if (!L->isLCSSAForm(DT))
+    formLCSSA(*L, DT, &LI, &SE);
+
+  /* 1. Validate the ranges at the end of the preheader */
+  InstrumentationIRBuilder IRB(InsertPt);
+  // Neither the call nor its result is checked by the sub-sanitizers.
+  auto NoSanitized = [](Value *V) {
+    if (auto *I = dyn_cast<Instruction>(V))
+      NoSanitize::set(*I);
+    return V;
+  };
+  Value *IsClean = nullptr;
+  for (const AccessRange &R : Ranges) {
+    Value *Beg = Expander.expandCodeFor(R.Beg, IRB.getInt8PtrTy(), InsertPt);
+    Value *End = Expander.expandCodeFor(R.End, IRB.getInt8PtrTy(), InsertPt);
+    Value *Clean = NoSanitized(IRB.CreateICmpNE(
+        NoSanitized(IRB.CreateCall(XsanRangeIsClean, {Beg, End})),
+        IRB.getInt32(0)));
+    IsClean = IsClean ? NoSanitized(IRB.CreateAnd(IsClean, Clean)) : Clean;
+  }
+
+  /* 2. Clone the loop with a new preheader, and branch to it if clean */
+  BasicBlock *Preheader = SplitBlock(CheckBB, InsertPt, &DT, &LI, nullptr,
+                                     L->getHeader()->getName() + ".xsan.ph");
+  ValueToValueMapTy VMap;
+  SmallVector<BasicBlock *, 8> ClonedBlocks;
+  Loop *Cloned = cloneLoopWithPreheader(Preheader, CheckBB, L, VMap,
+                                        ".xsan.lver", &LI, &DT, ClonedBlocks);
+  remapInstructionsInBlocks(ClonedBlocks, VMap);
+
+  Instruction *Term = CheckBB->getTerminator();
+  NoSanitize::set(*BranchInst::Create(Cloned->getLoopPreheader(), Preheader,
+                                      IsClean, Term));
+  Term->eraseFromParent();
+  DT.changeImmediateDominator(Exit, CheckBB);
+
+  /* 3. Merge the values of the clone in the exit block */
+  BasicBlock *ClonedExiting = cast<BasicBlock>(VMap[Exiting]);
+  for (PHINode &PN : Exit->phis()) {
+    Value *V = PN.getIncomingValueForBlock(Exiting);
+    Value *ClonedV = VMap.lookup(V);
+    PN.addIncoming(ClonedV ? ClonedV : V, ClonedExiting);
+    SE.forgetValue(&PN);
+  }
+  SE.forgetLoop(L);
+
+  /* 4. ASan skips the MOPs of the clone covered by the ranges */
+  for (const AccessRange &R : Ranges) {
+    for (Instruction *Mop : R.Mops)
+      LoopVersioned::set(*cast<Instruction>(VMap[Mop]));
+    NumVersionedMops += R.Mops.size();
+  }
+  ++NumLoopsVersioned;
+  return true;
+}
+
 } // namespace __xsan
@@ -163,6 +163,8 @@ private:
   const DominatorTree &DT;
   AAResults &AA;
   DenseMap<const Loop *, SmallVector<MemoryLocation, 8>> StoresInLoop;
+  // Calls that write memory in the loop, collected with the stores.
+  DenseMap<const Loop *, SmallVector<const CallBase *, 2>> WritingCallsInLoop;
 };
 
 enum class LoopOptLeval {
@@ -211,16 +213,23 @@ private:
   LoopMopInstrumenter(Function &F, FunctionAnalysisManager &FAM,
                       LoopOptLeval OptLevel);
 
-  // A simple loop is currently defined as a loop with
-  // 1. single header, exit, latch, exiting. predecessor.
+  // A simple loop is currently defined as a combinable loop with single exit
+  // and exiting.
+  bool isSimpleLoop(const Loop *L);
+  // A combinable loop is currently defined as a loop with
+  // 1. single header, latch, predecessor, and exitings that branch or switch.
   // 2. conatains no atomic instructions and
-  //    no function calls (apart from pure readonly function)
+  //    no function calls apart from the benign ones (see isBenignCall).
   /// TODO: for ASan, such restrictions can be relaxed.
-  /// TODO: if the MOP is ahead of all exiting, multiple exitings
-  ///       do not affect the loop optimization.
   /// TOOD: migrate to LLVM16+, which introduced attribute `memory(...)`
   ///       and implemented more precise memory description.
-  bool isSimpleLoop(const Loop *L);
+  bool isCombinableLoop(const Loop *L);
+  // Returns the AddRec of the parent loop of AR's loop, if the runs of AR's
+  // loop access adjacent ranges through the MOP, or nullptr. MopBB is the
+  // block of AR's loop that accesses the range in each of its iterations.
+  const SCEVAddRecExpr *getRangeInParentLoop(const SCEVAddRecExpr *AR,
+                                             const BasicBlock *MopBB,
+                                             ScalarEvolution &SE);
 
   /// Filter out those obvious duplicate MOPs in the same BB,
   /// being formalized as follows
@@ -254,7 +263,7 @@ private:
   PostDominatorTree &PDT;
   const DataLayout &DL;
 
-  SmallPtrSet<const Loop *, 16> SimpleLoops;
+  SmallPtrSet<const Loop *, 16> CombinableLoops;
   SmallPtrSet<const Loop *, 16> ComplexLoops;
   SmallVector<LoopMop, 16> LoopMopCandidates;
   bool MopCollected;
@@ -271,4 +280,75 @@ private:
   LoopInvariantChecker LIC;
 };
 
+/*
+ Version the simple innermost loops whose accessed ranges are computable at the
+ preheader, i.e., the MOP addresses are affine in the loop and its
+ backedge-taken count is known:
+
+   if (__xsan_range_is_clean(beg_0, end_0) && ... )
+     loop';  // The clone, in which ASan skips the MOPs covered by the ranges.
+   else
+     loop;   // Instrumented as usual, e.g., by LoopMopInstrumenter.
+
+ Each range covers all the iterations, even for the MOPs in branches, so that
+ the clone only runs if none of its accesses would be reported by ASan. As a
+ simple loop calls no function that may write memory, nothing is poisoned
+ while the loop runs.
+ */
+class LoopVersioningInstrumenter {
+private:
+  /// The range [Beg, End) accessed by the MOPs over all the loop iterations.
+  struct AccessRange {
+    const SCEV *Beg;
+    const SCEV *End;
+    SmallVector<Instruction *, 4> Mops;
+  };
+
+public:
+  static LoopVersioningInstrumenter create(Function &F,
+                                           FunctionAnalysisManager &FAM);
+
+  void instrument();
+
+private:
+  LoopVersioningInstrumenter(Function &F, FunctionAnalysisManager &FAM);
+
+  bool isVersionable(const Loop *L);
+  void collectAccessRanges(const Loop *L, SmallVectorImpl<AccessRange> &Ranges);
+  bool versionLoop(Loop *L, SmallVectorImpl<AccessRange> &Ranges);
+
+  Function &F;
+  FunctionAnalysisManager &FAM;
+  LoopInfo &LI;
+  DominatorTree &DT;
+  ScalarEvolution &SE;
+  const DataLayout &DL;
+
+  FunctionCallee XsanRangeIsClean;
+};
+
+/*
+  Runs the MopIR passes designated by -xsan-mop-pipeline on a function before
+  any sub-sanitizer, and tags the MOPs whose checks are elided with
+  MopCheckElided, so that ASan, TSan and MSan honour the same decisions.
+*/
+class CheckedArgSummaries;
+
+class MopIRInstrumenter {
+public:
+  static MopIRInstrumenter create(Function &F, FunctionAnalysisManager &FAM,
+                                  const CheckedArgSummaries &Summaries);
+
+  void instrument();
+
+private:
+  MopIRInstrumenter(Function &F, FunctionAnalysisManager &FAM,
+                    const CheckedArgSummaries &Summaries);
+
+  Function &F;
+  FunctionAnalysisManager &FAM;
+  /// The arguments checked by the callees, for the whole module.
+  const CheckedArgSummaries &Summaries;
+};
+
 } // namespace __xsan
\ No newline at end of file
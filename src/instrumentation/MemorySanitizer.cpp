@@ -404,6 +404,20 @@ static const MemoryMapParams XSan_Linux_X86_64_MemoryMapParams = {
     __xsan::MappingX64_48::kMSanShadowAdd, // OriginBase
 };
 
+// getShadowOriginPtrUserspace lowers the generated XSan formulas as
+// Shadow = Addr ^ XorMask and Origin = Shadow + OriginBase.
+template <typename Mapping> constexpr bool isXorThenAdd(uint64_t Addr) {
+  return Mapping::MSanMemToShadow(Addr) == (Addr ^ Mapping::kMSanShadowXor) &&
+         Mapping::MSanMemToOrigin(Addr) ==
+             (Addr ^ Mapping::kMSanShadowXor) + Mapping::kMSanShadowAdd;
+}
+static_assert(isXorThenAdd<__xsan::MappingX64_48>(
+                  __xsan::MappingX64_48::kHeapMemBeg),
+              "XSan's MSan mapping is not Xor+Add on x86_64");
+static_assert(isXorThenAdd<__xsan::MappingAarch64_48>(
+                  __xsan::MappingAarch64_48::kHeapMemBeg),
+              "XSan's MSan mapping is not Xor+Add on aarch64");
+
 // mips64 Linux
 static const MemoryMapParams Linux_MIPS64_MemoryMapParams = {
   0,               // AndMask (not used)
@@ -2055,7 +2069,9 @@ struct MemorySanitizerVisitor : public InstVisitor<MemorySanitizerVisitor> {
       setShadow(&I, getCleanShadow(&I));
     }
 
-    if (ClCheckAccessAddress)
+    // The address check is skipped if MopIR found it covered by another one,
+    // while the shadow is still propagated.
+    if (ClCheckAccessAddress && !__xsan::MopCheckElided::is(I))
       insertShadowCheck(I.getPointerOperand(), &I);
 
     if (I.isAtomic())
@@ -2078,7 +2094,7 @@ struct MemorySanitizerVisitor : public InstVisitor<MemorySanitizerVisitor> {
   /// Optionally, checks that the store address is fully defined.
   void visitStoreInst(StoreInst &I) {
     StoreList.push_back(&I);
-    if (ClCheckAccessAddress)
+    if (ClCheckAccessAddress && !__xsan::MopCheckElided::is(I))
       insertShadowCheck(I.getPointerOperand(), &I);
   }
 
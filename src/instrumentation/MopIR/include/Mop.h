@@ -89,6 +89,14 @@ struct AccessPatternInfo {
   bool hasKnownPattern() const { return Pattern != AccessPattern::Unknown; }
 };
 
+// 合并后的访问：[Base + Offset, Base + Offset + Size)
+struct MergedAccess {
+  llvm::Value* Base = nullptr;      // 公共基地址
+  int64_t Offset = 0;               // 相对 Base 的起始偏移（字节）
+  uint64_t Size = 0;                // 合并后的访问大小（字节）
+  uint64_t Alignment = 1;           // 起始地址的已知对齐
+};
+
 // MOP基类
 class Mop {
 private:
@@ -99,11 +107,14 @@ private:
   bool IsRedundant;                       // 标记是否为冗余MOP（用于优化）
   Mop* CoveringMop;                       // 覆盖此MOP的另一个MOP（如果冗余）
   AccessPatternInfo PatternInfo;          // 访问模式信息（用于插桩优化）
+  Mop* MergeLeader;                       // 合并组中发出合并检查的 MOP
+  MergedAccess Merged;                    // 合并后的访问（仅对 leader 有效）
 
 public:
   Mop(MopType Ty, const llvm::MemoryLocation& Loc, llvm::Instruction* Inst)
     : Type(Ty), Location(Loc), OriginalInst(Inst), 
-      IsRedundant(false), CoveringMop(nullptr), PatternInfo() {}
+      IsRedundant(false), CoveringMop(nullptr), PatternInfo(),
+      MergeLeader(nullptr) {}
   
   // 访问器方法
   MopType getType() const { return Type; }
@@ -127,6 +138,14 @@ public:
   Mop* getCoveringMop() const { return CoveringMop; }
   void setCoveringMop(Mop* Covering) { CoveringMop = Covering; }
   
+  // 合并相关方法：组内每个 MOP 的检查由 leader 处的一次合并检查代替
+  bool isMerged() const { return MergeLeader != nullptr; }
+  bool isMergeLeader() const { return MergeLeader == this; }
+  Mop* getMergeLeader() const { return MergeLeader; }
+  void setMergeLeader(Mop* Leader) { MergeLeader = Leader; }
+  const MergedAccess& getMergedAccess() const { return Merged; }
+  void setMergedAccess(const MergedAccess& Access) { Merged = Access; }
+  
   // 访问模式相关方法
   const AccessPatternInfo& getAccessPattern() const { return PatternInfo; }
   AccessPatternInfo& getAccessPattern() { return PatternInfo; }
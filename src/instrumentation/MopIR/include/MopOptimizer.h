@@ -6,6 +6,8 @@
 #include "llvm/IR/Function.h"
 
 namespace __xsan {
+class CheckedArgSummaries;
+
 namespace MopIR {
 
 // MOP优化器基类
@@ -27,13 +29,42 @@ public:
   virtual const char* getName() const = 0;
 };
 
-// 连续读取合并优化器
-class ContiguousReadMerger : public MopOptimizer {
+// 连续访问合并：同一基本块内、中间没有调用等同步点的相邻读（或写），
+// 若基于同一基地址且覆盖连续无空洞的区间，则合并为一次检查，
+// 由组内最早执行的 MOP 处发出。
+// 只合并 8 字节对齐、大小为 8 的 MOP，并按 4 或 8 个连续的 8 字节单元成组，
+// 使 TSan 的每个 shadow cell 仍被整体访问，且运行时能按单元报告出错的 MOP。
+// 各子 sanitizer 静态过滤掉的 MOP（vptr、常量数据、未逃逸的局部对象、
+// ASan 可证明不越界的访问）不参与合并，以免被宽检查重新检查。
+class ContiguousAccessMerger : public MopOptimizer {
+private:
+  bool IsWrite;
+
+protected:
+  explicit ContiguousAccessMerger(bool IsWrite) : IsWrite(IsWrite) {}
+
 public:
   void optimize(MopList& Mops) override;
+
+private:
+  // 合并一段无同步点的 MOP 中的连续访问
+  void mergeWindow(llvm::ArrayRef<Mop*> Window);
+};
+
+// 连续读取合并优化器
+class ContiguousReadMerger : public ContiguousAccessMerger {
+public:
+  ContiguousReadMerger() : ContiguousAccessMerger(/*IsWrite=*/false) {}
   const char* getName() const override { return "ContiguousReadMerger"; }
 };
 
+// 连续写入合并优化器
+class ContiguousWriteMerger : public ContiguousAccessMerger {
+public:
+  ContiguousWriteMerger() : ContiguousAccessMerger(/*IsWrite=*/true) {}
+  const char* getName() const override { return "ContiguousWriteMerger"; }
+};
+
 // 冗余写入消除优化器
 class RedundantWriteEliminator : public MopOptimizer {
 public:
@@ -41,6 +72,35 @@ public:
   const char* getName() const override { return "RedundantWriteEliminator"; }
 };
 
+// 复发检查消除优化器：复用 MopRecurrenceReducer 的复发图求解，
+// 未进入支配集的 MOP 标记为冗余。WriteSensitive 对应 TSan 的写敏感模式。
+class RecurringCheckEliminator : public MopOptimizer {
+private:
+  bool WriteSensitive;
+
+public:
+  explicit RecurringCheckEliminator(bool WriteSensitive)
+    : WriteSensitive(WriteSensitive) {}
+  void optimize(MopList& Mops) override;
+  const char* getName() const override { return "RecurringCheckEliminator"; }
+};
+
+// 跨过程的参数检查消除：被调函数在每次调用时、任何同步点之前都会检查的参数
+// 区间（见 CheckedArgSummaries），在同一基本块内、调用之前且中间没有同步点的
+// MOP 无需再检查。WriteSensitive 对应 TSan 的写敏感模式：写只能被写覆盖。
+class CheckedArgEliminator : public MopOptimizer {
+private:
+  const CheckedArgSummaries& Summaries;
+  bool WriteSensitive;
+
+public:
+  CheckedArgEliminator(const CheckedArgSummaries& Summaries,
+                       bool WriteSensitive)
+    : Summaries(Summaries), WriteSensitive(WriteSensitive) {}
+  void optimize(MopList& Mops) override;
+  const char* getName() const override { return "CheckedArgEliminator"; }
+};
+
 // MOP优化流水线
 class MopOptimizationPipeline {
 private:
@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "../include/ActiveMopAnalysis.h"
+#include "../../Utils/ValueUtils.h"
 
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/PostOrderIterator.h"
@@ -47,7 +48,7 @@ static bool isClobberingCall(const Instruction *Inst,
   if (!Inst->mayWriteToMemory())
     return false;
 
-  return true;
+  return mayFreeOrSynchronize(*cast<CallBase>(Inst));
 }
 
 
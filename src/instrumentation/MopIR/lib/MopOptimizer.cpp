@@ -1,5 +1,12 @@
 #include "../include/MopOptimizer.h"
 #include "../include/MopContext.h"
+#include "../../Analysis/CheckedArgSummary.h"
+#include "../../Analysis/MopRecurrenceReducer.h"
+#include "../../Utils/Statistics.h"
+#include "../../Utils/ValueUtils.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/Analysis/AliasAnalysis.h"
@@ -11,9 +18,14 @@
 #include "llvm/Analysis/PostDominators.h"
 #include "llvm/IR/Instructions.h"
 
+#define DEBUG_TYPE "xsan-mopir"
+
 using namespace __xsan::MopIR;
 using namespace llvm;
 
+XSAN_STATISTIC(NumCheckedArgElided,
+               "Number of MOP checks covered by the argument checks of callees");
+
 // ============================================================================
 // MopOptimizationPipeline 实现
 // ============================================================================
@@ -32,34 +44,299 @@ void MopOptimizationPipeline::run(MopList& Mops) {
 }
 
 // ============================================================================
-// ContiguousReadMerger 实现（占位实现）
+// ContiguousAccessMerger 实现
 // ============================================================================
 
-void ContiguousReadMerger::optimize(MopList& Mops) {
+// 子 sanitizer 静态过滤掉的 MOP 不应被合并：合并后由 XSan 的宽检查统一检查，
+// 会让 TSan 检查 vptr 等访问而误报，或白白检查 ASan 已证明安全的访问。
+static bool isFilteredBySanitizers(Instruction &I,
+                                   ObjectSizeOffsetVisitor &ObjSizeVis,
+                                   const DataLayout &DL) {
+  // TSan 单独处理 vptr 的读写
+  if (MDNode *Tag = I.getMetadata(LLVMContext::MD_tbaa))
+    if (Tag->isTBAAVtableAccess())
+      return true;
+  Value *Addr = getLoadStorePointerOperand(&I);
+  // 常量数据不会与写竞争
+  if (isa<LoadInst>(I) && __xsan::addrPointsToConstantDataAggressive(Addr))
+    return true;
+  // 未逃逸的局部对象只被当前线程访问
+  if (__xsan::isUncapturedFuncLocal(*Addr))
+    return true;
+  // ASan 不检查对全局变量和栈变量的常量偏移、不越界的访问
+  const Value *Object = getUnderlyingObject(Addr);
+  if (!isa<AllocaInst>(Object) && !isa<GlobalVariable>(Object))
+    return false;
+  SizeOffsetType SizeOffset = ObjSizeVis.compute(Addr);
+  if (!ObjSizeVis.bothKnown(SizeOffset))
+    return false;
+  uint64_t Size = SizeOffset.first.getZExtValue();
+  int64_t Offset = SizeOffset.second.getSExtValue();
+  uint64_t NeededSize =
+      DL.getTypeStoreSize(getLoadStoreType(&I)).getFixedSize();
+  return Offset >= 0 && Size >= uint64_t(Offset) &&
+         Size - uint64_t(Offset) >= NeededSize;
+}
+
+void ContiguousAccessMerger::optimize(MopList& Mops) {
   if (!Context) {
     return;
   }
-  
-  // TODO: 实现连续读取合并优化
-  // 这里先留空，后续可以添加：
-  // 1. 识别连续的读取操作
-  // 2. 检查内存位置是否相邻
-  // 3. 合并相邻的读取操作
+
+  const DataLayout &DL = Context->getDataLayout();
+  Function &F = Context->getFunction();
+  ObjectSizeOpts ObjSizeOpts;
+  ObjSizeOpts.RoundToAlign = true;
+  ObjectSizeOffsetVisitor ObjSizeVis(DL, &Context->getTargetLibraryInfo(),
+                                     F.getContext(), ObjSizeOpts);
+  DenseMap<const Instruction*, Mop*> Candidates;
+  for (auto &M : Mops) {
+    Instruction *I = M->getOriginalInst();
+    bool IsSimple = IsWrite ? isa<StoreInst>(I) && cast<StoreInst>(I)->isSimple()
+                            : isa<LoadInst>(I) && cast<LoadInst>(I)->isSimple();
+    // 合并后的检查由 XSan 的运行时完成，只支持默认地址空间
+    if (IsSimple && !M->isMerged() && !M->isRedundant() &&
+        getLoadStorePointerOperand(I)->getType()->getPointerAddressSpace() ==
+            0 &&
+        !isFilteredBySanitizers(*I, ObjSizeVis, DL))
+      Candidates[I] = M.get();
+  }
+  if (Candidates.size() < 2)
+    return;
+
+  // 按程序顺序收集两个同步点之间的 MOP
+  SmallVector<Mop*, 16> Window;
+  for (BasicBlock &BB : F) {
+    for (Instruction &I : BB) {
+      if (Mop *M = Candidates.lookup(&I)) {
+        Window.push_back(M);
+      } else if (__xsan::isMopBarrier(I)) {
+        mergeWindow(Window);
+        Window.clear();
+      }
+    }
+    mergeWindow(Window);
+    Window.clear();
+  }
+}
+
+void ContiguousAccessMerger::mergeWindow(ArrayRef<Mop*> Window) {
+  if (Window.size() < 2)
+    return;
+
+  struct Access {
+    Mop* M;
+    int64_t Offset;
+    unsigned Order;  // 在窗口中的程序顺序
+  };
+
+  // 基地址 -> 基于它的常量偏移访问，只收集对齐的整个 8 字节单元
+  const DataLayout &DL = Context->getDataLayout();
+  MapVector<Value*, SmallVector<Access, 8>> Buckets;
+  for (unsigned Order = 0; Order < Window.size(); ++Order) {
+    Mop *M = Window[Order];
+    Instruction *I = M->getOriginalInst();
+    TypeSize StoreSize = DL.getTypeStoreSize(getLoadStoreType(I));
+    if (StoreSize.isScalable() || StoreSize.getFixedSize() != 8 ||
+        getLoadStoreAlignment(I).value() < 8)
+      continue;
+    int64_t Offset = 0;
+    Value *Base =
+        GetPointerBaseWithConstantOffset(getLoadStorePointerOperand(I), Offset,
+                                         DL);
+    Buckets[Base].push_back({M, Offset, Order});
+  }
+
+  for (auto &[Base, Accesses] : Buckets) {
+    if (Accesses.size() < 4)
+      continue;
+    llvm::sort(Accesses, [](const Access &A, const Access &B) {
+      return A.Offset < B.Offset;
+    });
+
+    // 每段连续的单元按 8 个或 4 个一组合并为一次 64 或 32 字节的检查，
+    // 剩下的单元保留各自的检查
+    for (size_t Beg = 0, End; Beg < Accesses.size(); Beg = End) {
+      End = Beg + 1;
+      unsigned NumCells = 1;
+      while (End < Accesses.size() && NumCells < 8) {
+        int64_t Next = Accesses[Beg].Offset + 8 * NumCells;
+        if (Accesses[End].Offset == Next - 8) {
+          ++End;  // 同一单元的重复访问
+        } else if (Accesses[End].Offset == Next) {
+          ++End;
+          ++NumCells;
+        } else {
+          break;
+        }
+      }
+      while (End < Accesses.size() &&
+             Accesses[End].Offset == Accesses[Beg].Offset + 8 * (NumCells - 1))
+        ++End;
+      if (NumCells < 4)
+        continue;
+      if (NumCells < 8) {
+        // 只合并前 4 个单元，其余的留给下一组
+        NumCells = 4;
+        End = Beg;
+        while (End < Accesses.size() &&
+               Accesses[End].Offset < Accesses[Beg].Offset + 32)
+          ++End;
+      }
+
+      ArrayRef<Access> Group = makeArrayRef(Accesses).slice(Beg, End - Beg);
+      const Access &Leader = *std::min_element(
+          Group.begin(), Group.end(), [](const Access &A, const Access &B) {
+            return A.Order < B.Order;
+          });
+      MergedAccess Merged;
+      Merged.Base = Base;
+      Merged.Offset = Accesses[Beg].Offset;
+      Merged.Size = 8 * NumCells;
+      Merged.Alignment = 8;
+      Leader.M->setMergedAccess(Merged);
+      for (const Access &A : Group)
+        A.M->setMergeLeader(Leader.M);
+    }
+  }
 }
 
 // ============================================================================
-// RedundantWriteEliminator 实现（占位实现）
+// RedundantWriteEliminator 实现
 // ============================================================================
 
+// 同一基本块内，若一个写之后（中间没有调用、原子操作等同步点或可能不返回的
+// 指令）还有一个对同一地址、不小于它的写，则后者的检查覆盖前者。
+// 自后向前遍历基本块，记录每个地址上之后最大的写。
 void RedundantWriteEliminator::optimize(MopList& Mops) {
   if (!Context) {
     return;
   }
-  
-  // TODO: 实现冗余写入消除优化
-  // 这里先留空，后续可以添加：
-  // 1. 识别冗余的写入操作
-  // 2. 标记为冗余
-  // 3. 在插桩时跳过
+
+  const DataLayout &DL = Context->getDataLayout();
+  DenseMap<const Instruction*, Mop*> StoreMops;
+  for (auto &M : Mops) {
+    auto *SI = dyn_cast_or_null<StoreInst>(M->getOriginalInst());
+    if (SI && SI->isSimple() && !M->isRedundant())
+      StoreMops[SI] = M.get();
+  }
+  if (StoreMops.size() < 2)
+    return;
+
+  // 地址 -> (之后最大的写大小, 对应的 MOP)
+  DenseMap<const Value*, std::pair<uint64_t, Mop*>> LaterStores;
+  for (BasicBlock &BB : Context->getFunction()) {
+    LaterStores.clear();
+    for (Instruction &I : reverse(BB)) {
+      if (Mop *M = StoreMops.lookup(&I)) {
+        auto *SI = cast<StoreInst>(&I);
+        const Value *Ptr = SI->getPointerOperand()->stripPointerCasts();
+        Type *Ty = SI->getValueOperand()->getType();
+        uint64_t Size = DL.getTypeStoreSize(Ty).getFixedSize();
+        auto [It, Inserted] = LaterStores.try_emplace(Ptr, Size, M);
+        if (Inserted)
+          continue;
+        if (Size <= It->second.first) {
+          M->setRedundant(true);
+          M->setCoveringMop(It->second.second);
+        } else {
+          It->second = {Size, M};
+        }
+        continue;
+      }
+      if (__xsan::isMopBarrier(I))
+        LaterStores.clear();
+    }
+  }
+}
+
+// ============================================================================
+// RecurringCheckEliminator 实现
+// ============================================================================
+
+void RecurringCheckEliminator::optimize(MopList& Mops) {
+  if (!Context || !Context->getAnalysisManager()) {
+    return;
+  }
+
+  SmallVector<const Instruction*, 16> Insts;
+  for (auto &M : Mops) {
+    Instruction *I = M->getOriginalInst();
+    if (!M->isRedundant() && (isa<LoadInst>(I) || isa<StoreInst>(I)))
+      Insts.push_back(I);
+  }
+  if (Insts.size() < 2)
+    return;
+
+  __xsan::MopRecurrenceReducer Reducer(Context->getFunction(),
+                               *Context->getAnalysisManager());
+  SmallVector<const Instruction*, 16> Distilled =
+      Reducer.distillRecurringChecks(Insts, WriteSensitive);
+  SmallPtrSet<const Instruction*, 16> Survivors(Distilled.begin(),
+                                                Distilled.end());
+
+  // 支配集只给出幸存者，不记录具体的覆盖者。
+  for (auto &M : Mops) {
+    Instruction *I = M->getOriginalInst();
+    if (!M->isRedundant() && (isa<LoadInst>(I) || isa<StoreInst>(I)) &&
+        !Survivors.contains(I))
+      M->setRedundant(true);
+  }
 }
 
+// ============================================================================
+// CheckedArgEliminator 实现
+// ============================================================================
+
+// 自后向前遍历基本块，记录之后的调用中被调函数检查的区间；遇到同步点时清空。
+// 调用本身也可能是同步点，但被调函数在其第一个同步点之前就已检查这些区间。
+void CheckedArgEliminator::optimize(MopList& Mops) {
+  if (!Context) {
+    return;
+  }
+
+  DenseMap<const Instruction*, Mop*> Candidates;
+  for (auto &M : Mops) {
+    Instruction *I = M->getOriginalInst();
+    if (M->isRedundant() || M->isMerged())
+      continue;
+    if (auto *LI = dyn_cast<LoadInst>(I); LI && LI->isSimple())
+      Candidates[I] = M.get();
+    else if (auto *SI = dyn_cast<StoreInst>(I); SI && SI->isSimple())
+      Candidates[I] = M.get();
+  }
+  if (Candidates.empty())
+    return;
+
+  const DataLayout &DL = Context->getDataLayout();
+  SmallVector<__xsan::CheckedRange, 8> LaterRanges;
+  for (BasicBlock &BB : Context->getFunction()) {
+    LaterRanges.clear();
+    for (Instruction &I : reverse(BB)) {
+      if (Mop *M = Candidates.lookup(&I)) {
+        TypeSize StoreSize = DL.getTypeStoreSize(getLoadStoreType(&I));
+        if (StoreSize.isScalable() || LaterRanges.empty())
+          continue;
+        int64_t Offset = 0;
+        const Value *Base = GetPointerBaseWithConstantOffset(
+            getLoadStorePointerOperand(&I), Offset, DL);
+        int64_t End = Offset + StoreSize.getFixedSize();
+        bool IsWrite = isa<StoreInst>(I);
+        for (const __xsan::CheckedRange &R : LaterRanges) {
+          if (R.Base == Base && R.Offset <= Offset &&
+              End <= R.Offset + (int64_t)R.Size &&
+              (!WriteSensitive || !IsWrite || R.IsWrite)) {
+            M->setRedundant(true);
+            ++NumCheckedArgElided;
+            break;
+          }
+        }
+        continue;
+      }
+      if (__xsan::isMopBarrier(I))
+        LaterRanges.clear();
+      if (auto *CB = dyn_cast<CallBase>(&I); CB && !__xsan::isNoSanitize(I))
+        Summaries.getCheckedRanges(*CB, LaterRanges);
+    }
+  }
+}
@@ -0,0 +1,166 @@
+//===-- MopIRInstrumenter.cpp - Shared optimizations of MOP checks --------===//
+//
+// This file is a part of XSan, a composition of different Sanitizers.
+//
+// Runs the MopIR pipeline once per function, before the sub-sanitizers, and
+// records its decisions on the IR. Each sub-sanitizer then skips the MOPs
+// tagged with MopCheckElided instead of reducing its checks on its own.
+// Contiguous MOPs are checked at once by a wide check of XSan, and are tagged
+// with DelegateToXSan like the MOPs checked by the loop optimizations.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Analysis/CheckedArgSummary.h"
+#include "Instrumentation.h"
+#include "MopIR/include/MopBuilder.h"
+#include "MopIR/include/MopContext.h"
+#include "MopIR/include/MopOptimizer.h"
+#include "Utils/Logging.h"
+#include "Utils/MetaDataUtils.h"
+#include "Utils/Options.h"
+#include "Utils/Statistics.h"
+#include "Utils/ValueUtils.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/ErrorHandling.h"
+
+#define DEBUG_TYPE "xsan-mopir"
+
+using namespace llvm;
+
+namespace __xsan {
+
+XSAN_STATISTIC(NumMopIRMops, "Number of MOPs seen by the MopIR pipeline");
+XSAN_STATISTIC(NumMopIRElided, "Number of MOP checks elided by MopIR");
+XSAN_STATISTIC(NumMopIRMerged, "Number of MOPs coalesced by MopIR");
+XSAN_STATISTIC(NumMopIRWideChecks,
+               "Number of wide checks of coalesced MOPs inserted by MopIR");
+
+/// Recurring checks are reduced for the whole composition, so they are only
+/// reduced if none of the enabled sub-sanitizers opts out.
+static bool shouldReduceRecurrence() {
+  using namespace options;
+  return opt::enableReccReduction() &&
+         (ClDisableAsan || opt::ClReccReduceAsan) &&
+         (ClDisableTsan || opt::ClReccReduceTsan);
+}
+
+static void buildPipeline(MopIR::MopOptimizationPipeline &Pipeline,
+                          const CheckedArgSummaries &Summaries) {
+  SmallVector<StringRef, 4> Names;
+  SplitString(options::opt::ClMopPipeline, Names, ",");
+  for (StringRef Name : Names) {
+    Name = Name.trim();
+    if (Name == "recurrence") {
+      // TSan requires the covering MOP to also write if the covered one does,
+      // which is also sound for the other sub-sanitizers.
+      if (shouldReduceRecurrence())
+        Pipeline.addOptimizer(std::make_unique<MopIR::RecurringCheckEliminator>(
+            /*WriteSensitive=*/!options::ClDisableTsan));
+    } else if (Name == "redundant-write") {
+      Pipeline.addOptimizer(
+          std::make_unique<MopIR::RedundantWriteEliminator>());
+    } else if (Name == "checked-args") {
+      // As for the recurring checks, a write is only covered by a write of the
+      // callee if TSan is enabled.
+      Pipeline.addOptimizer(std::make_unique<MopIR::CheckedArgEliminator>(
+          Summaries, /*WriteSensitive=*/!options::ClDisableTsan));
+    } else if (Name == "contiguous-read") {
+      Pipeline.addOptimizer(std::make_unique<MopIR::ContiguousReadMerger>());
+    } else if (Name == "contiguous-write") {
+      Pipeline.addOptimizer(std::make_unique<MopIR::ContiguousWriteMerger>());
+    } else {
+      report_fatal_error("Unknown pass '" + Name +
+                         "' in -xsan-mop-pipeline, expected one of "
+                         "recurrence, redundant-write, checked-args, "
+                         "contiguous-read and contiguous-write");
+    }
+  }
+}
+
+/// Checks the 32 or 64 bytes accessed by a group of coalesced MOPs before its
+/// leader by __xsan_{read,write}N. On a poisoned cell, the runtime reports the
+/// 8-byte access of the MOP covering it.
+static void insertWideCheck(MopIR::Mop &Leader) {
+  Instruction *I = Leader.getOriginalInst();
+  const MopIR::MergedAccess &Access = Leader.getMergedAccess();
+  assert((Access.Size == 32 || Access.Size == 64) && Access.Alignment >= 8 &&
+         "Only groups of 4 or 8 aligned cells are coalesced");
+  bool IsWrite = isa<StoreInst>(I);
+  Module &M = *I->getModule();
+  InstrumentationIRBuilder IRB(I);
+
+  AttributeList Attr;
+  Attr = Attr.addFnAttribute(M.getContext(), Attribute::NoUnwind);
+  Value *Beg = IRB.CreateConstGEP1_64(
+      IRB.getInt8Ty(), IRB.CreatePointerCast(Access.Base, IRB.getInt8PtrTy()),
+      Access.Offset);
+  // The caller PC is reported, as for the other checks of XSan.
+  Value *Pc = IRB.getInt64(0);
+  FunctionCallee Check = M.getOrInsertFunction(
+      (IsWrite ? "__xsan_write" : "__xsan_read") + utostr(Access.Size), Attr,
+      IRB.getVoidTy(), IRB.getInt8PtrTy(), IRB.getInt64Ty());
+  IRB.CreateCall(Check, {Beg, Pc});
+}
+
+MopIRInstrumenter
+MopIRInstrumenter::create(Function &F, FunctionAnalysisManager &FAM,
+                          const CheckedArgSummaries &Summaries) {
+  MopIRInstrumenter MII(F, FAM, Summaries);
+  return MII;
+}
+
+MopIRInstrumenter::MopIRInstrumenter(Function &F, FunctionAnalysisManager &FAM,
+                                     const CheckedArgSummaries &Summaries)
+    : F(F), FAM(FAM), Summaries(Summaries) {}
+
+void MopIRInstrumenter::instrument() {
+  MopIR::MopList Mops = MopIR::MopBuilder(F).buildMopList();
+  // MOPs inserted by other instrumentations, or already checked by XSan's
+  // loop optimizations, are not checked by the sub-sanitizers anyway. The
+  // MOPs of a versioned loop are unchecked by ASan, so they may neither cover
+  // other MOPs nor get a wide check back.
+  Mops.erase(remove_if(Mops,
+                       [](const std::unique_ptr<MopIR::Mop> &M) {
+                         const Instruction &I = *M->getOriginalInst();
+                         return shouldSkip(I) || LoopVersioned::is(I);
+                       }),
+             Mops.end());
+  if (Mops.empty())
+    return;
+
+  MopIR::MopContext Context(F, FAM);
+  MopIR::MopOptimizationPipeline Pipeline;
+  Pipeline.setContext(Context);
+  buildPipeline(Pipeline, Summaries);
+  Pipeline.run(Mops);
+
+  size_t NumElided = 0, NumMerged = 0, NumWideChecks = 0;
+  for (auto &M : Mops) {
+    // A coalesced MOP may be found redundant by a later pass, but the wide
+    // check of its group still has to be inserted.
+    if (M->isMerged()) {
+      if (M->isMergeLeader()) {
+        insertWideCheck(*M);
+        NumWideChecks++;
+      }
+      DelegateToXSan::set(*M->getOriginalInst());
+      NumMerged++;
+    } else if (M->isRedundant()) {
+      MopCheckElided::set(*M->getOriginalInst());
+      NumElided++;
+    }
+  }
+
+  NumMopIRMops += Mops.size();
+  NumMopIRElided += NumElided;
+  NumMopIRMerged += NumMerged;
+  NumMopIRWideChecks += NumWideChecks;
+  if (options::ClDebug) {
+    Log.setFunction(F.getName());
+    Log.addLog("[MopIR] Eliding MOP checks", Mops.size(),
+               Mops.size() - NumElided);
+    Log.addLog("[MopIR] Coalescing MOP checks", NumMerged, NumWideChecks);
+  }
+}
+
+} // namespace __xsan
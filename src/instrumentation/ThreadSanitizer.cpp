@@ -56,6 +56,8 @@
 #include "PassRegistry.h"
 #include "Utils/MetaDataUtils.h"
 #include "Utils/Options.h"
+#include "Utils/Statistics.h"
+#include "Utils/ValueUtils.h"
 
 using namespace llvm;
 
@@ -103,6 +105,8 @@ STATISTIC(NumOmittedReadsFromConstantGlobals,
           "Number of reads from constant globals");
 STATISTIC(NumOmittedReadsFromVtable, "Number of vtable reads");
 STATISTIC(NumOmittedNonCaptured, "Number of accesses ignored due to capturing");
+XSAN_STATISTIC(NumThreadLocalChecksRemoved,
+               "Number of TSan checks of thread-local objects removed");
 
 const char kTsanModuleCtorName[] = "tsan.module_ctor";
 const char kTsanInitName[] = "__tsan_init";
@@ -485,8 +489,16 @@ void ThreadSanitizer::chooseInstructionsToInstrument(
       }
     }
 
-    if (isa<AllocaInst>(getUnderlyingObject(Addr)) &&
-        !PointerMayBeCaptured(Addr, true, true)) {
+    if (__xsan::options::opt::enableTsanOptThreadLocal()) {
+      // Unlike below, the captures of the whole object are tracked, which
+      // also covers the heap objects never leaving the thread.
+      if (__xsan::isUncapturedFuncLocal(*Addr)) {
+        NumOmittedNonCaptured++;
+        ++NumThreadLocalChecksRemoved;
+        continue;
+      }
+    } else if (isa<AllocaInst>(getUnderlyingObject(Addr)) &&
+               !PointerMayBeCaptured(Addr, true, true)) {
       // The variable is addressable but not captured, so it cannot be
       // referenced from a different thread and participate in a data race
       // (see llvm/Analysis/CaptureTracking.h for details).
@@ -1013,6 +1025,9 @@ bool XsanThreadSanitizer::collectTargetsToIntrument(
         continue;
       if (__xsan::DelegateToXSan::is(Inst))
         continue;
+      // Skip MOPs whose checks are covered by others, as decided by MopIR.
+      if (__xsan::MopCheckElided::is(Inst))
+        continue;
       if (isTsanAtomic(&Inst))
         AtomicAccesses.push_back(&Inst);
       else if (isa<LoadInst>(Inst) || isa<StoreInst>(Inst))
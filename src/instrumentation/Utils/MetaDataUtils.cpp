@@ -169,6 +169,8 @@ INSTANTIATE_META_DATA_HELPER(ReplacedAllocaMeta)
 INSTANTIATE_META_DATA_HELPER(CopyArgsMeta, llvm::MemCpyInst)
 INSTANTIATE_META_DATA_HELPER(ReplacedAtomicMeta)
 INSTANTIATE_META_DATA_HELPER(UBSanInstMeta)
+INSTANTIATE_META_DATA_HELPER(MopCheckElidedMeta)
+INSTANTIATE_META_DATA_HELPER(LoopVersionedMeta)
 
 #undef INSTANTIATE_META_DATA_HELPER
 #undef INSTANTIATE_OPERAND_BUNDLE_HELPER
@@ -195,6 +195,23 @@ struct UBSanInstMeta {
   static constexpr char Name[] = "xsan.ubsan";
 };
 
+// ---------------------- MOP Check Elided --------------------------
+
+/// The check of the MOP is covered by the check of another MOP, as decided by
+/// the MopIR pipeline once for all the sub-sanitizers.
+struct MopCheckElidedMeta {
+  static constexpr char Name[] = "xsan.mop.elided";
+};
+
+// ---------------------- Loop Versioned ---------------------------
+
+/// The MOP lies in the clone of a loop whose accessed ranges have been found
+/// clean by ASan before the loop. ASan skips it, while the other sub-sanitizers
+/// instrument it as usual.
+struct LoopVersionedMeta {
+  static constexpr char Name[] = "xsan.loop.versioned";
+};
+
 // ---------------------- NoSanitize --------------------------------
 
 struct NoSanitizeMeta {
@@ -220,6 +237,8 @@ using ReplacedAlloca = MetaDataHelper<ReplacedAllocaMeta>;
 using CopyArgs = MetaDataHelper<CopyArgsMeta, llvm::MemCpyInst>;
 using ReplacedAtomic = MetaDataHelper<ReplacedAtomicMeta>;
 using UBSanInst = MetaDataHelper<UBSanInstMeta>;
+using MopCheckElided = MetaDataHelper<MopCheckElidedMeta>;
+using LoopVersioned = MetaDataHelper<LoopVersionedMeta>;
 using NoSanitize = MetaDataHelper<NoSanitizeMeta>;
 
 /// ---------------------- Util Functions ----------------------------
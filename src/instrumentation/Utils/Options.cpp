@@ -1,4 +1,9 @@
 #include "Options.h"
+#include "xsan_common.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstdlib>
 
 namespace __xsan {
 namespace options {
@@ -17,6 +22,11 @@ const cl::opt<bool>
     ClReccReduceTsan("xsan-reduce-rec-tsan",
                      cl::desc("Reduce recurring checks for TSan"), cl::Hidden,
                      cl::init(true));
+const cl::opt<unsigned> ClReccReduceBudget(
+    "xsan-reduce-rec-budget",
+    cl::desc("Maximum number of pairs of MOPs compared per function when "
+             "reducing recurring checks"),
+    cl::Hidden, cl::init(20000));
 
 /// TODO: The current analysis is still wrong, and we should not optimize the
 /// inspection of Data Race based on the assumption that Data Race does not
@@ -27,6 +37,11 @@ const cl::opt<bool>
     ClTsanOptStackObj("xsan-tsan-opt-stack-obj",
                       cl::desc("Optimize stack object for TSan"), cl::Hidden,
                       cl::init(false));
+const cl::opt<bool> ClTsanOptThreadLocal(
+    "xsan-tsan-opt-thread-local",
+    cl::desc("Skip TSan's checks of the stack and heap objects that never "
+             "escape to another thread"),
+    cl::Hidden, cl::init(true));
 
 const cl::opt<LoopOptLeval> ClLoopOpt(
     "xsan-loop-opt", cl::desc("Loop optimization level for XSan"),
@@ -48,6 +63,30 @@ const cl::opt<bool> ClPostOpt(
     cl::desc("Whether to perform post-sanitziers optimizations for XSan"),
     cl::Hidden);
 
+const cl::opt<std::string> ClMopPipeline(
+    "xsan-mop-pipeline",
+    cl::init("recurrence,redundant-write,checked-args,contiguous-read,"
+             "contiguous-write"),
+    cl::desc("Comma-separated MopIR passes shared by all sub-sanitizers "
+             "(recurrence, redundant-write, checked-args, contiguous-read, "
+             "contiguous-write), or empty to let each sub-sanitizer reduce "
+             "its own checks"),
+    cl::Hidden);
+
+const cl::opt<bool> ClLoopVersioning(
+    "xsan-loop-versioning",
+    cl::desc("Version the simple innermost loops whose accessed ranges are "
+             "computable before the loop, to run a clone without ASan's "
+             "checks if the ranges are clean"),
+    cl::Hidden, cl::init(true));
+
+const cl::opt<unsigned> ClInlineMemIntrinSize(
+    "xsan-inline-memintrin-size",
+    cl::desc("Expand the memset/memcpy/memmove of a constant length up to this "
+             "many bytes into loads and stores, instead of calling the "
+             "runtime"),
+    cl::Hidden, cl::init(16));
+
 } // namespace opt
 
 const cl::opt<bool> ClDisableAsan("xsan-disable-asan", cl::init(false),
@@ -66,6 +105,37 @@ const cl::opt<bool> ClDisableMsan("xsan-disable-msan",
 
 cl::opt<bool> ClDebug("xsan-debug", cl::init(false),
                       cl::desc("Enable debug output for XSan"), cl::Hidden);
+
+const cl::opt<bool> ClStats("xsan-stats", cl::init(false),
+                            cl::desc("Print the statistics of XSan"),
+                            cl::Hidden);
+
+const cl::opt<LtoPhase> ClLto(
+    "xsan-lto", cl::desc("The phase of (Thin)LTO to instrument in"),
+    cl::values(clEnumValN(LtoPhase::None, "none",
+                          "Instrument each module before code generation"),
+               clEnumValN(LtoPhase::PreLink, "pre-link",
+                          "Defer the instrumentation to the link time"),
+               clEnumValN(LtoPhase::PostLink, "post-link",
+                          "Instrument in the LTO backend")),
+    cl::Hidden, cl::init(LtoPhase::None));
+
+namespace opt {
+/// TSan still has to check every access of a versioned loop, which then gains
+/// too little from losing the combined checks of TSan.
+bool enableLoopVersioning() {
+  return ClOpt && ClLoopVersioning && !ClDisableAsan && ClDisableTsan;
+}
+} // namespace opt
+
+void parseLinkTimeOptions() {
+  // The options have been passed by -mllvm in the compiler.
+  if (ClLto != LtoPhase::None || !std::getenv(XSAN_LTO_OPTIONS_ENV))
+    return;
+  const char *Argv[] = {"xsan"};
+  if (!cl::ParseCommandLineOptions(1, Argv, "", &errs(), XSAN_LTO_OPTIONS_ENV))
+    report_fatal_error("Invalid options in " XSAN_LTO_OPTIONS_ENV);
+}
 } // namespace options
 
 } // namespace __xsan
\ No newline at end of file
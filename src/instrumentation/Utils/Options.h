@@ -17,8 +17,14 @@ extern const cl::opt<bool> ClReccReduce;
 extern const cl::opt<bool> ClReccReduceAsan;
 /// Whether to reduce the recurring checks for TSan.
 extern const cl::opt<bool> ClReccReduceTsan;
+/// The number of pairs of MOPs the reduction of recurring checks may compare
+/// in one function.
+extern const cl::opt<unsigned> ClReccReduceBudget;
 /// Whether to optimize the instrumentation of stack objects for TSan.
 extern const cl::opt<bool> ClTsanOptStackObj;
+/// Whether to skip TSan's checks of the objects proven not to escape to another
+/// thread, see isUncapturedFuncLocal.
+extern const cl::opt<bool> ClTsanOptThreadLocal;
 
 /// The level of loop optimization designated for XSan.
 /// - no: No loop optimization.
@@ -28,22 +34,63 @@ extern const cl::opt<bool> ClTsanOptStackObj;
 /// - full: Enable all loop optimizations as above.
 extern const cl::opt<LoopOptLeval> ClLoopOpt;
 
+/// Whether to version the simple innermost loops whose accessed ranges are
+/// computable before the loop, so that a loop validated by ASan at runtime
+/// runs a clone without ASan's checks.
+extern const cl::opt<bool> ClLoopVersioning;
+
 /// Whether to perform post-optimization.
 extern const cl::opt<bool> ClPostOpt;
 
+/// The comma-separated MopIR passes run before the sub-sanitizers, whose
+/// decisions are shared by all of them:
+/// - recurrence: drop the checks covered by recurring checks.
+/// - redundant-write: drop the checks of stores overwritten in the same block.
+/// - checked-args: drop the checks of the ranges a callee checks on every call.
+/// - contiguous-read: check contiguous reads of a block by one wide check.
+/// - contiguous-write: check contiguous writes of a block by one wide check.
+/// Empty to let each sub-sanitizer reduce its recurring checks on its own.
+extern const cl::opt<std::string> ClMopPipeline;
+
+/// The largest constant length of the memintrinsics expanded into loads and
+/// stores, which are then checked and optimized as ordinary MOPs.
+extern const cl::opt<unsigned> ClInlineMemIntrinSize;
+
 inline bool enableReccReduction() { return ClOpt && ClReccReduce; }
 
+inline bool enableMopPipeline() { return ClOpt && !ClMopPipeline.empty(); }
+
+inline unsigned inlineMemIntrinSize() {
+  return ClOpt ? ClInlineMemIntrinSize : 0;
+}
+
+/// Only the XSan pass runs the MopIR pipeline, which then supersedes the
+/// reduction of recurring checks of each sub-sanitizer.
+inline bool runsMopPipeline() {
+#ifdef XSAN_PASS
+  return enableMopPipeline();
+#else
+  return false;
+#endif
+}
+
 inline bool enableReccReductionAsan() {
-  return enableReccReduction() && ClReccReduceAsan;
+  return enableReccReduction() && ClReccReduceAsan && !runsMopPipeline();
 }
 inline bool enableReccReductionTsan() {
-  return enableReccReduction() && ClReccReduceTsan;
+  return enableReccReduction() && ClReccReduceTsan && !runsMopPipeline();
 }
 
 inline bool enableTsanOptStackObj() { return ClOpt && ClTsanOptStackObj; }
 
+inline bool enableTsanOptThreadLocal() { return ClOpt && ClTsanOptThreadLocal; }
+
 inline bool enablePostOpt() { return ClOpt && ClPostOpt; }
 
+/// TSan still has to check every access of a versioned loop, which then gains
+/// too little from losing the combined checks of TSan.
+bool enableLoopVersioning();
+
 inline LoopOptLeval loopOptLevel() {
   return ClOpt ? ClLoopOpt : LoopOptLeval::NoOpt;
 }
@@ -61,6 +108,20 @@ extern const cl::opt<bool> ClDisableMsan;
 /// Enable debug output.
 extern cl::opt<bool> ClDebug;
 
+/// Print the statistics of XSan's instrumentation.
+extern const cl::opt<bool> ClStats;
+
+/// The phase of (Thin)LTO that XSan's instrumentation runs in.
+/// - none: instrument each module at the end of its optimization pipeline.
+/// - pre-link: leave the instrumentation to the link time.
+/// - post-link: instrument in the LTO backend, after cross-module inlining.
+enum class LtoPhase { None, PreLink, PostLink };
+extern const cl::opt<LtoPhase> ClLto;
+
+/// In the linker, parses the options passed by the compiler wrapper through
+/// XSAN_LTO_OPTIONS_ENV, which -mllvm could not pass to the plugin.
+void parseLinkTimeOptions();
+
 } // namespace options
 
 } // namespace __xsan
\ No newline at end of file
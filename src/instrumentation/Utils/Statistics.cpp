@@ -0,0 +1,33 @@
+#include "Statistics.h"
+#include "Options.h"
+#include "llvm/Support/Format.h"
+
+using namespace llvm;
+
+namespace __xsan {
+namespace stats {
+
+// Counters are only registered by static constructors, and the list head is
+// zero-initialized before any of them runs.
+static Counter *Counters;
+
+Counter::Counter(const char *Group, const char *Desc)
+    : Group(Group), Desc(Desc), Next(Counters) {
+  Counters = this;
+}
+
+void print(raw_ostream &OS, StringRef Title) {
+  if (!options::ClStats)
+    return;
+  OS << "===== XSan statistics: " << Title << " =====\n";
+  for (Counter *C = Counters; C; C = C->Next) {
+    if (!C->Value)
+      continue;
+    OS << format("%12llu %s - %s\n", (unsigned long long)C->Value, C->Group,
+                 C->Desc);
+    C->Value = 0;
+  }
+}
+
+} // namespace stats
+} // namespace __xsan
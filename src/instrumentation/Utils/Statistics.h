@@ -0,0 +1,61 @@
+#pragma once
+
+#include "llvm/Support/raw_ostream.h"
+#include <chrono>
+#include <cstdint>
+
+namespace __xsan {
+namespace stats {
+using namespace llvm;
+
+/// A counter of XSan's instrumentation, printed at the end of the XSan pass
+/// with -xsan-stats. Unlike llvm::Statistic, it is also collected by release
+/// builds of LLVM, which is what XSan is used with.
+class Counter {
+public:
+  Counter(const char *Group, const char *Desc);
+
+  Counter &operator+=(uint64_t V) {
+    Value += V;
+    return *this;
+  }
+  Counter &operator++() {
+    ++Value;
+    return *this;
+  }
+  uint64_t value() const { return Value; }
+
+private:
+  friend void print(raw_ostream &OS, StringRef Title);
+
+  const char *const Group;
+  const char *const Desc;
+  uint64_t Value = 0;
+  Counter *Next;
+};
+
+/// Adds the wall time spent in its scope, in microseconds, to a counter.
+class ScopedTimer {
+public:
+  explicit ScopedTimer(Counter &C)
+      : C(C), Start(std::chrono::steady_clock::now()) {}
+  ~ScopedTimer() {
+    C += std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - Start)
+             .count();
+  }
+
+private:
+  Counter &C;
+  const std::chrono::steady_clock::time_point Start;
+};
+
+/// Prints the non-zero counters if -xsan-stats is given, and resets them.
+void print(raw_ostream &OS, StringRef Title);
+
+} // namespace stats
+} // namespace __xsan
+
+/// Define a counter in the group DEBUG_TYPE, similar to STATISTIC.
+#define XSAN_STATISTIC(VARNAME, DESC)                                          \
+  static ::__xsan::stats::Counter VARNAME(DEBUG_TYPE, DESC)
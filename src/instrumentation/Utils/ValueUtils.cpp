@@ -7,6 +7,7 @@
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/GlobalVariable.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Value.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
 
@@ -29,6 +30,24 @@ const llvm::Value *extractAddrFromLoadStoreInst(const llvm::Instruction &I) {
   return nullptr;
 }
 
+bool mayFreeOrSynchronize(const CallBase &CB) {
+  // Intrinsics are nofree and nosync by default, though some of them poison
+  // memory, e.g., llvm.lifetime.end under ASan.
+  if (isa<IntrinsicInst>(CB))
+    return true;
+  return !CB.hasFnAttr(Attribute::NoFree) || !CB.hasFnAttr(Attribute::NoSync);
+}
+
+bool isMopBarrier(const Instruction &I) {
+  if (isa<DbgInfoIntrinsic>(I) || isNoSanitize(I))
+    return false;
+  if (const auto *CB = dyn_cast<CallBase>(&I))
+    if (mayFreeOrSynchronize(*CB))
+      return true;
+  return I.isAtomic() || isa<FenceInst>(I) || I.isVolatile() ||
+         !isGuaranteedToTransferExecutionToSuccessor(&I);
+}
+
 const Value *getUnderlyingObjectAggressive(const Value *V) {
   const unsigned MaxVisited = 8;
 
@@ -138,12 +157,8 @@ static bool isByValArgument(const Value *V) {
   return false;
 }
 
-/// `alloc` is handled in other place, this function is for other cases.
-/// 1. `byval` pointer argument
-/// 2. `noalias` call return value
-/// 3. `alloc` stack object
-/// Note that `noalias` argument should have been a function local, but because
-/// it belongs to capture by return in the context of TSan, it is not included.
+// The captures are tracked from the underlying object rather than from Addr,
+// as any other pointer derived from the object may let it escape.
 bool isUncapturedFuncLocal(const Value &Addr) {
   const Value *Underlying = getUnderlyingObjectAggressive(&Addr);
   bool IsFuncLocal = isa<AllocaInst>(Underlying) || isNoAliasCall(Underlying) ||
@@ -16,16 +16,27 @@ bool shouldSkip(const llvm::Instruction &I);
 
 const llvm::Value *extractAddrFromLoadStoreInst(const llvm::Instruction &I);
 
+/// Whether the call may free memory (for ASan) or synchronize with other
+/// threads (for TSan), so that a check before it does not cover the same MOP
+/// after it. Relies on the nofree and nosync attributes inferred from the
+/// callee's body, which LTO makes visible across modules.
+bool mayFreeOrSynchronize(const llvm::CallBase &CB);
+
+/// Whether a check before \p I may not cover the same MOP after it: calls that
+/// may free or synchronize, atomics, fences, volatile accesses, and the
+/// instructions that may not transfer execution to their successor.
+bool isMopBarrier(const llvm::Instruction &I);
+
 /// Direct migrated from new version LLVM, which introduced by this PR:
 /// https://github.com/llvm/llvm-project/pull/99509
 const llvm::Value *getUnderlyingObjectAggressive(const llvm::Value *V);
 
 bool addrPointsToConstantDataAggressive(const llvm::Value *Addr);
 
-/// `alloc` is handled in other place, this function is for other cases.
-/// 1. `byval` pointer argument
-/// 2. `noalias` call return value
-/// 3. `alloc` stack object
+/// Whether \p Addr is based on an object that never escapes to another thread:
+/// an alloca, a `byval` argument or a `noalias` call like malloc, which is
+/// never stored to memory, returned, or passed to a call that may capture it,
+/// e.g., pthread_create. Only the accesses of the current thread may touch it.
 /// Note that `noalias` argument should have been a function local, but because
 /// it belongs to capture by return in the context of TSan, it is not included.
 bool isUncapturedFuncLocal(const llvm::Value &Addr);
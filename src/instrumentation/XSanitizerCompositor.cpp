@@ -1,11 +1,16 @@
+#include "Analysis/CheckedArgSummary.h"
 #include "AttributeTaggingPass.hpp"
 #include "Instrumentation.h"
 #include "PassRegistry.h"
 #include "UbsanInstTagging.hpp"
 #include "Utils/Logging.h"
 #include "Utils/Options.h"
+#include "Utils/Statistics.h"
+#include "Utils/ValueUtils.h"
 #include "debug.h"
 #include "xsan_common.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringSwitch.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/InstVisitor.h"
 #include "llvm/IR/LLVMContext.h"
@@ -13,9 +18,14 @@
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Passes/PassPlugin.h"
 
+#define DEBUG_TYPE "xsan"
+
 using namespace llvm;
 using namespace __xsan;
 
+XSAN_STATISTIC(NumMemIntrinExpanded,
+               "Number of small memintrinsics expanded into loads and stores");
+
 namespace __xsan {
 
 static void verifyOriginalPassNotRun(Module &M) {
@@ -62,7 +72,23 @@ void registerAnalysisForXsan(PassBuilder &PB) {
   }
 }
 
+/// Parses "xsan-lto" or "xsan-lto<O#>", which instruments the module after the
+/// LTO pipeline of the linker.
+static Optional<OptimizationLevel> parseLtoPassName(StringRef Name) {
+  if (!Name.consume_front("xsan-lto"))
+    return None;
+  if (Name.empty())
+    return OptimizationLevel::O2;
+  return StringSwitch<Optional<OptimizationLevel>>(Name)
+      .Case("<O0>", OptimizationLevel::O0)
+      .Case("<O1>", OptimizationLevel::O1)
+      .Case("<O2>", OptimizationLevel::O2)
+      .Case("<O3>", OptimizationLevel::O3)
+      .Default(None);
+}
+
 void registerXsanForClangAndOpt(llvm::PassBuilder &PB) {
+  options::parseLinkTimeOptions();
   registerAnalysisForXsan(PB);
 
   // Register on the start of the pipeline.
@@ -71,10 +97,13 @@ void registerXsanForClangAndOpt(llvm::PassBuilder &PB) {
         MPM.addPass(UbsanInstTaggingPass());
       });
 
-  // Register on the end of the pipeline.
+  // Register on the end of the pipeline. In the pre-link phase of LTO, the
+  // modules are left to be instrumented after the cross-module optimizations,
+  // i.e., at the end of ThinLTO's backend pipeline.
   PB.registerOptimizerLastEPCallback(
       [=](ModulePassManager &MPM, OptimizationLevel level) {
-        MPM.addPass(SanitizerCompositorPass(level));
+        if (options::ClLto != options::LtoPhase::PreLink)
+          MPM.addPass(SanitizerCompositorPass(level));
       });
 
   // 这里注册opt回调的名称
@@ -87,6 +116,12 @@ void registerXsanForClangAndOpt(llvm::PassBuilder &PB) {
           MPM.addPass(SanitizerCompositorPass(OptimizationLevel::O0));
           return true;
         }
+        // The full LTO pipeline of LLVM 15 has no extension point at its end,
+        // so the compiler wrapper appends this pass to the linker's pipeline.
+        if (auto Level = parseLtoPassName(Name)) {
+          MPM.addPass(SanitizerCompositorPass(*Level));
+          return true;
+        }
         return false;
       });
 }
@@ -108,7 +143,8 @@ struct XSanVisitor : public InstVisitor<XSanVisitor> {
   }
 
   void visitMemSetInst(MemSetInst &I) {
-    I.getIntrinsicID();
+    if (expandSmallMemIntrinsic(I))
+      return;
     IRBuilder<> IRB(&I);
     IRB.CreateCall(MemsetFn,
                    {I.getArgOperand(0), I.getArgOperand(1),
@@ -116,6 +152,8 @@ struct XSanVisitor : public InstVisitor<XSanVisitor> {
     I.eraseFromParent();
   }
   void visitMemCpyInst(MemCpyInst &I) {
+    if (expandSmallMemIntrinsic(I))
+      return;
     IRBuilder<> IRB(&I);
     IRB.CreateCall(MemcpyFn,
                    {I.getArgOperand(0), I.getArgOperand(1),
@@ -123,6 +161,8 @@ struct XSanVisitor : public InstVisitor<XSanVisitor> {
     I.eraseFromParent();
   }
   void visitMemMoveInst(MemMoveInst &I) {
+    if (expandSmallMemIntrinsic(I))
+      return;
     IRBuilder<> IRB(&I);
     IRB.CreateCall(MemmoveFn,
                    {I.getArgOperand(0), I.getArgOperand(1),
@@ -131,6 +171,63 @@ struct XSanVisitor : public InstVisitor<XSanVisitor> {
   }
 
 private:
+  /// Expands a memintrinsic of a small constant length into loads and stores
+  /// of at most 8 bytes, which are then checked and optimized as ordinary
+  /// MOPs instead of going through the interceptor of the runtime.
+  bool expandSmallMemIntrinsic(MemIntrinsic &I) {
+    unsigned MaxSize = options::opt::inlineMemIntrinSize();
+    auto *Len = dyn_cast<ConstantInt>(I.getLength());
+    if (!MaxSize || !Len || Len->getZExtValue() > MaxSize || I.isVolatile() ||
+        isNoSanitize(I))
+      return false;
+
+    IRBuilder<> IRB(&I);
+    uint64_t Size = Len->getZExtValue();
+    SmallVector<std::pair<uint64_t, IntegerType *>, 4> Chunks;
+    for (uint64_t Offset = 0; Offset < Size;) {
+      uint64_t ChunkSize = std::min<uint64_t>(8, PowerOf2Floor(Size - Offset));
+      Chunks.push_back({Offset, IRB.getIntNTy(ChunkSize * 8)});
+      Offset += ChunkSize;
+    }
+    auto ChunkPtr = [&](Value *Base, uint64_t Offset, Type *Ty) {
+      unsigned AS = Base->getType()->getPointerAddressSpace();
+      Value *Ptr = IRB.CreateConstGEP1_64(
+          IRB.getInt8Ty(),
+          IRB.CreatePointerCast(Base, IRB.getInt8PtrTy(AS)), Offset);
+      return IRB.CreatePointerCast(Ptr, Ty->getPointerTo(AS));
+    };
+
+    Value *Dst = I.getRawDest();
+    Align DstAlign = I.getDestAlign().valueOrOne();
+    if (auto *MS = dyn_cast<MemSetInst>(&I)) {
+      for (auto [Offset, Ty] : Chunks) {
+        // Splat the byte over the chunk, e.g., 0xab -> 0xabababab.
+        Value *V = IRB.CreateMul(
+            IRB.CreateZExt(MS->getValue(), Ty),
+            ConstantInt::get(Ty, APInt::getSplat(Ty->getBitWidth(),
+                                                 APInt(8, 1))));
+        IRB.CreateAlignedStore(V, ChunkPtr(Dst, Offset, Ty),
+                               commonAlignment(DstAlign, Offset));
+      }
+    } else {
+      auto &MT = cast<MemTransferInst>(I);
+      Value *Src = MT.getRawSource();
+      Align SrcAlign = MT.getSourceAlign().valueOrOne();
+      // All the chunks are loaded before any is stored, as the ranges of
+      // memmove may overlap.
+      SmallVector<Value *, 4> Vals;
+      for (auto [Offset, Ty] : Chunks)
+        Vals.push_back(IRB.CreateAlignedLoad(Ty, ChunkPtr(Src, Offset, Ty),
+                                             commonAlignment(SrcAlign, Offset)));
+      for (auto [Chunk, V] : zip(Chunks, Vals))
+        IRB.CreateAlignedStore(V, ChunkPtr(Dst, Chunk.first, Chunk.second),
+                               commonAlignment(DstAlign, Chunk.first));
+    }
+    I.eraseFromParent();
+    ++NumMemIntrinExpanded;
+    return true;
+  }
+
   void initializeType(Module &M) {
     LLVMContext &C = M.getContext();
     IRBuilder<> IRB(C);
@@ -168,10 +265,16 @@ PreservedAnalyses SanitizerCompositorPass::run(Module &M,
   XSanVisitor Visitor(M);
 
   LoopOptLeval level = options::opt::loopOptLevel();
-  if (level != LoopOptLeval::NoOpt) {
+  /// Loop versioning has its own flag, so it also runs without loop opt.
+  if (level != LoopOptLeval::NoOpt || options::opt::enableLoopVersioning()) {
     for (auto &F : M) {
       if (F.isDeclaration() || F.empty())
         continue;
+      /// The versioned loops fall back to the loops optimized as follows.
+      if (options::opt::enableLoopVersioning())
+        LoopVersioningInstrumenter::create(F, FAM).instrument();
+      if (level == LoopOptLeval::NoOpt)
+        continue;
       LoopMopInstrumenter LoopInstrumenter =
           LoopMopInstrumenter::create(F, FAM, level);
       LoopInstrumenter.instrument();
@@ -179,6 +282,17 @@ PreservedAnalyses SanitizerCompositorPass::run(Module &M,
     }
   }
 
+  /// Decide once which checks are elided, for all sub-sanitizers.
+  if (options::opt::enableMopPipeline()) {
+    /// Summarized before any function is changed by the pipeline.
+    CheckedArgSummaries Summaries(M);
+    for (auto &F : M) {
+      if (F.isDeclaration() || F.empty())
+        continue;
+      MopIRInstrumenter::create(F, FAM, Summaries).instrument();
+    }
+  }
+
   SubSanitizers Sanitizers = SubSanitizers::loadSubSanitizers(Level);
   /// Unlike ModulePassManager, SubSanitizers does not invalidate Analysises
   /// between the runnings of sanitizers' passes.
@@ -194,6 +308,7 @@ PreservedAnalyses SanitizerCompositorPass::run(Module &M,
   }
 
   Log.displayLogs(M.getName());
+  stats::print(errs(), M.getName());
 
   return PA;
 }
@@ -100,7 +100,12 @@ class Origin {
   }
 
   static Origin CreateHeapOrigin(StackTrace *stack) {
-    u32 stack_id = StackDepotPut(*stack);
+    return CreateHeapOrigin(StackDepotPut(*stack));
+  }
+
+  // The stack of the heap origin is already in the depot, e.g., put by XSan's
+  // allocator which shares the ID among the sanitizers.
+  static Origin CreateHeapOrigin(u32 stack_id) {
     CHECK(stack_id);
     CHECK((stack_id & kHeapIdMask) == stack_id);
     return Origin(stack_id);
@@ -230,6 +230,11 @@ struct QuarantineCallback {
 
       PoisonShadow(m->Beg(), RoundUpTo(m->UsedSize(), ASAN_SHADOW_GRANULARITY),
                    kAsanHeapLeftRedzoneMagic);
+
+      /// The free hooks were skipped in Deallocate, see
+      /// __xsan::ShouldBatchXsanFreeHook.
+      if (__xsan::ShouldBatchXsanFreeHook())
+        __xsan::XsanRecycleHook(m->Beg(), m->UsedSize());
     }
 
     // Statistics.
@@ -382,9 +387,24 @@ struct Allocator {
     atomic_store(&max_redzone, options.max_redzone, memory_order_release);
   }
 
+  // Returns the start of the reserved heap if the arena is not placed at a
+  // fixed address, but at the heap of the mapping selected for the VMA size.
+  static uptr ReserveHeap() {
+#if SANITIZER_CAN_USE_ALLOCATOR64 && defined(__aarch64__) && \
+    XSAN_AARCH64_MIN_VMA < 48
+    uptr heap_beg = __xsan::HeapMemBeg();
+    CHECK_LE(heap_beg + kAllocatorSize, __xsan::HeapMemEnd());
+    CHECK(MmapFixedNoReserve(heap_beg, kAllocatorSize, "XSan heap"));
+    return heap_beg;
+#else
+    return 0;
+#endif
+  }
+
   void InitLinkerInitialized(const AllocatorOptions &options) {
     SetAllocatorMayReturnNull(options.may_return_null);
-    allocator.InitLinkerInitialized(options.release_to_os_interval_ms);
+    allocator.InitLinkerInitialized(options.release_to_os_interval_ms,
+                                    ReserveHeap());
     SharedInitCode(options);
     max_user_defined_malloc_size = common_flags()->max_allocation_size_mb
                                        ? common_flags()->max_allocation_size_mb
@@ -654,7 +674,7 @@ struct Allocator {
 
     if (!__xsan::ShouldSanitzerIgnoreAllocFreeHook())
       RunFreeHooks(ptr);
-    __xsan::XsanFreeHook(p, true, stack);
+    __xsan::XsanFreeHook(p, true, stack, 0);
 
     AsanThread *t = GetCurrentThread();
     if (t) {
@@ -769,7 +789,11 @@ struct Allocator {
     m->SetUsedSize(size);
     m->user_requested_alignment_log = user_requested_alignment_log;
 
-    m->SetAllocContext(t ? t->tid() : kMainTid, StackDepotPut(*stack));
+    // The stack is put into the depot once, and shared with the sub-sanitizers
+    // (e.g., as MSan's heap origin), which expect it to be tagged.
+    stack->tag = StackTrace::TAG_ALLOC;
+    u32 alloc_stack_id = StackDepotPut(*stack);
+    m->SetAllocContext(t ? t->tid() : kMainTid, alloc_stack_id);
 
     u8 shadow_val = *(u8 *)MEM_TO_SHADOW((uptr)allocated);
     /// Maybe the new allocated chunk was used as internal heap block.
@@ -821,7 +845,7 @@ struct Allocator {
       reinterpret_cast<LargeChunkHeader *>(alloc_beg)->Set(m);
     }
     /// TODO: figure out should we transfer user_ptr or real_ptr?
-    __xsan::XsanAllocHook(user_beg, size, stack);
+    __xsan::XsanAllocHook(user_beg, size, stack, alloc_stack_id);
     __xsan::XsanAllocFreeTailHook(stack->trace[0]);
     RunMallocHooks(res, size);
     return res;
@@ -848,11 +872,12 @@ struct Allocator {
 
   // Expects the chunk to already be marked as quarantined by using
   // AtomicallySetQuarantineFlagIfAllocated.
-  void QuarantineChunk(AsanChunk *m, void *ptr, BufferedStackTrace *stack) {
+  void QuarantineChunk(AsanChunk *m, void *ptr, BufferedStackTrace *stack,
+                       u32 free_stack_id) {
     CHECK_EQ(atomic_load(&m->chunk_state, memory_order_relaxed),
              CHUNK_QUARANTINE);
     AsanThread *t = GetCurrentThread();
-    m->SetFreeContext(t ? t->tid() : 0, StackDepotPut(*stack));
+    m->SetFreeContext(t ? t->tid() : 0, free_stack_id);
 
     // Push into quarantine.
     if (t) {
@@ -920,13 +945,23 @@ struct Allocator {
       }
     }
 
-    __xsan::XsanFreeHook(p, m->UsedSize(), stack);
-    
+    // As on allocation, the free stack is put into the depot once.
+    stack->tag = StackTrace::TAG_DEALLOC;
+    u32 free_stack_id = StackDepotPut(*stack);
+
+    // Until the chunk is recycled, ASan reports any access to it after the
+    // free, so the sub-sanitizers that only care about such accesses (MSan's
+    // poisoning) can be notified in Recycle instead. Note that it does not
+    // hold for the accesses racing with the free, hence TSan vetoes it.
+    if (!__xsan::ShouldBatchXsanFreeHook() ||
+        !get_allocator().FromPrimary(ptr))
+      __xsan::XsanFreeHook(p, m->UsedSize(), stack, free_stack_id);
+
     AsanStats &thread_stats = GetCurrentThreadStats();
     thread_stats.frees++;
     thread_stats.freed += m->UsedSize();
 
-    QuarantineChunk(m, ptr, stack);
+    QuarantineChunk(m, ptr, stack, free_stack_id);
 
     __xsan::XsanAllocFreeTailHook(stack->trace[0]);
   }
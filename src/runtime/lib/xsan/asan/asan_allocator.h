@@ -198,10 +198,23 @@ const uptr kAllocatorSpace = 0x600000000000ULL;
 const uptr kAllocatorSize  =  0x20000000000ULL;  // 2T.
 typedef DefaultSizeClassMap SizeClassMap;
 #    elif defined(__aarch64__)
-/// TODO: aarch64 needs to support 39, 42 and 48 bit VMA.
+#      if XSAN_AARCH64_MIN_VMA < 48
+// The heap differs between the VMA sizes, so the arena is placed at the heap
+// of the mapping selected at startup (see Allocator::InitLinkerInitialized),
+// and is as large as the smallest heap of the supported VMA sizes.
+#        if XSAN_AARCH64_MIN_VMA == 39
+using AllocatorHeapMapping = __xsan::MappingAarch64_39;
+#        else
+using AllocatorHeapMapping = __xsan::MappingAarch64_42;
+#        endif
+const uptr kAllocatorSpace = ~(uptr)0;
+const uptr kAllocatorSize =
+    AllocatorHeapMapping::kHeapMemEnd - AllocatorHeapMapping::kHeapMemBeg;
+#      else
 const uptr kAllocatorSpace = __xsan::MappingAarch64_48::kHeapMemBeg;
 const uptr kAllocatorSize = __xsan::MappingAarch64_48::kHeapMemEnd -
                             __xsan::MappingAarch64_48::kHeapMemBeg;
+#      endif
 typedef VeryCompactSizeClassMap SizeClassMap;
 #    elif SANITIZER_RISCV64
 const uptr kAllocatorSpace = ~(uptr)0;
@@ -4,6 +4,7 @@
 #include "asan_mapping.h"
 #include "asan_thread.h"
 #include "lsan/lsan_common.h"
+#include "xsan_simd.h"
 
 namespace __asan {
 
@@ -138,18 +139,83 @@ ASAN_INTERFACE_HOOK(2, unaligned_write, unaligned_store)
 ASAN_INTERFACE_HOOK(4, unaligned_write, unaligned_store)
 ASAN_INTERFACE_HOOK(8, unaligned_write, unaligned_store)
 
-ASAN_INTERFACE_HOOK(1, read, load)
-ASAN_INTERFACE_HOOK(2, read, load)
-ASAN_INTERFACE_HOOK(4, read, load)
-ASAN_INTERFACE_HOOK(8, read, load)
-ASAN_INTERFACE_HOOK(16, read, load)
+#undef ASAN_INTERFACE_HOOK
 
-ASAN_INTERFACE_HOOK(1, write, store)
-ASAN_INTERFACE_HOOK(2, write, store)
-ASAN_INTERFACE_HOOK(4, write, store)
-ASAN_INTERFACE_HOOK(8, write, store)
-ASAN_INTERFACE_HOOK(16, write, store)
+// Periods not longer than this many granules are checked by scanning the
+// shadow of the whole span, since each vector load then covers at least one
+// element. Longer periods peek at the shadow of each element instead.
+static constexpr uptr kDensePeriodGranules = 32;
+
+template <u32 AccessSize, bool IsWrite>
+ALWAYS_INLINE void AccessMemoryOne(uptr p) {
+  if (IsWrite)
+    AsanHooks::__xsan_write<AccessSize>(p);
+  else
+    AsanHooks::__xsan_read<AccessSize>(p);
+}
 
-#undef ASAN_INTERFACE_HOOK
+/// Check the periodic accesses {beg + k * step | k < n} in bulk. Only the
+/// elements overlapping a non-zero shadow byte go through the precise (and
+/// reporting) check of __asan_loadN/__asan_storeN.
+template <u32 AccessSize, bool IsWrite>
+static void AccessMemoryPeriod(uptr beg, uptr end, uptr step) {
+  const uptr n = (end - beg + step - 1) / step;
+  if (step > kDensePeriodGranules * ASAN_SHADOW_GRANULARITY) {
+    for (uptr p = beg; p < end; p += step) {
+      // An unaligned element of 16 bytes spans 3 granules, so the middle one
+      // is checked as well.
+      const u8 *s = (const u8 *)MemToShadow(p);
+      const u8 *s_last = (const u8 *)MemToShadow(p + AccessSize - 1);
+      while (s <= s_last && LIKELY(!*s)) ++s;
+      if (LIKELY(s > s_last))
+        continue;
+      AccessMemoryOne<AccessSize, IsWrite>(p);
+    }
+    return;
+  }
+
+  const uptr last = beg + (n - 1) * step + AccessSize - 1;
+  const u8 *shadow = (const u8 *)MemToShadow(beg);
+  const u8 *shadow_end = (const u8 *)MemToShadow(last) + 1;
+  // Elements before `next_k` have been checked precisely already, as an
+  // element may span several granules.
+  uptr next_k = 0;
+  while (true) {
+    shadow += __xsan::FindFirstNonZeroByte(shadow, shadow_end - shadow);
+    if (LIKELY(shadow == shadow_end))
+      return;
+    // Elements [k_lo, k_hi] overlap the granule [g, g + granularity).
+    const uptr g = ShadowToMem((uptr)shadow);
+    const uptr lo =
+        g + 1 >= beg + AccessSize ? g + 1 - AccessSize - beg : 0;
+    const uptr k_lo = Max(next_k, (lo + step - 1) / step);
+    const uptr k_hi =
+        Min(n - 1, (g + ASAN_SHADOW_GRANULARITY - 1 - beg) / step);
+    for (uptr k = k_lo; k <= k_hi; ++k)
+      AccessMemoryOne<AccessSize, IsWrite>(beg + k * step);
+    next_k = Max(next_k, k_hi + 1);
+    ++shadow;
+  }
+}
+
+#define ASAN_PERIOD_HOOK(size)                                          \
+  template <>                                                           \
+  void AsanHooks::__xsan_period_read<size>(uptr beg, uptr end,          \
+                                           uptr step) {                 \
+    AccessMemoryPeriod<size, false>(beg, end, step);                    \
+  }                                                                     \
+  template <>                                                           \
+  void AsanHooks::__xsan_period_write<size>(uptr beg, uptr end,         \
+                                            uptr step) {                \
+    AccessMemoryPeriod<size, true>(beg, end, step);                     \
+  }
+
+ASAN_PERIOD_HOOK(1)
+ASAN_PERIOD_HOOK(2)
+ASAN_PERIOD_HOOK(4)
+ASAN_PERIOD_HOOK(8)
+ASAN_PERIOD_HOOK(16)
+
+#undef ASAN_PERIOD_HOOK
 
 }  // namespace __asan
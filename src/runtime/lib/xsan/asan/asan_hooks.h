@@ -70,6 +70,19 @@ struct AsanHooks : ::__xsan::DefaultHooks<AsanContext, AsanHooksThread> {
     }
     return map_ranges;
   }
+  ALWAYS_INLINE static ArrayRef<__xsan::NamedRange> HotShadowRanges() {
+    static bool initialized = false;
+    static __xsan::NamedRange hot_ranges[1];
+    if (!initialized) {
+      initialized = true;
+      hot_ranges[0] = {{(__xsan::HeapMemBeg() >> AsanShadowScale()) +
+                            AsanShadowOffset(),
+                        (__xsan::HeapMemEnd() >> AsanShadowScale()) +
+                            AsanShadowOffset()},
+                       "asan shadow heap"};
+    }
+    return hot_ranges;
+  }
   // ---------------------- Memory Management Hooks -------------------
   /// As XSan uses ASan's heap allocator and fake stack directly, hence we don't
   /// need to invoke ASan's hooks here.
@@ -139,6 +152,26 @@ struct AsanHooks : ::__xsan::DefaultHooks<AsanContext, AsanHooksThread> {
                                      uptr size, const char *func_name) {
     AccessMemoryRange(ctx, (uptr)offset, size, false, func_name);
   }
+  // A piece spans at most a few granules, of which only the last one may be
+  // partially addressable.
+  ALWAYS_INLINE static bool StringPieceNeedsCheck(uptr beg, uptr end) {
+    const s8 *shadow = (const s8 *)MemToShadow(beg);
+    const s8 *last = (const s8 *)MemToShadow(end - 1);
+    for (; shadow < last; ++shadow)
+      if (*shadow)
+        return true;
+    return *last &&
+           (s8)((end - 1) & (AsanShadowGranularity() - 1)) >= *last;
+  }
+  ALWAYS_INLINE static bool MayReportRange(uptr beg, uptr size) {
+    return __asan_region_is_poisoned(beg, size);
+  }
+  PSEUDO_MACRO static void ReadScannedString(Context *ctx, const void *offset,
+                                             uptr size, bool need_check,
+                                             const char *func_name) {
+    if (UNLIKELY(need_check))
+      AccessMemoryRange(ctx, (uptr)offset, size, false, func_name);
+  }
   PSEUDO_MACRO static void WriteRange(Context *ctx, const void *offset,
                                       uptr size, const char *func_name) {
     AccessMemoryRange(ctx, (uptr)offset, size, true, func_name);
@@ -186,8 +219,54 @@ struct AsanHooks : ::__xsan::DefaultHooks<AsanContext, AsanHooksThread> {
   static void __xsan_read(uptr p);
   template <u32 WriteSize>
   static void __xsan_write(uptr p);
+  template <u32 ReadSize>
+  static void __xsan_period_read(uptr beg, uptr end, uptr step);
+  template <u32 WriteSize>
+  static void __xsan_period_write(uptr beg, uptr end, uptr step);
 };
 
+// The shadow byte is checked inline so that the fused access check in
+// xsan_hooks.h only calls into ASan for accesses near poisoned memory.
+#define ASAN_INTERFACE_HOOK(size, operation, asan_operation)         \
+  template <>                                                        \
+  ALWAYS_INLINE void AsanHooks::__xsan_##operation<size>(uptr p) {   \
+    if (LIKELY(AsanQuickCheckForUnpoisonedAccess_<size>(p)))         \
+      return;                                                        \
+    __asan_##asan_operation##size(p);                                \
+  }
+
+ASAN_INTERFACE_HOOK(1, read, load)
+ASAN_INTERFACE_HOOK(2, read, load)
+ASAN_INTERFACE_HOOK(4, read, load)
+ASAN_INTERFACE_HOOK(8, read, load)
+ASAN_INTERFACE_HOOK(16, read, load)
+
+ASAN_INTERFACE_HOOK(1, write, store)
+ASAN_INTERFACE_HOOK(2, write, store)
+ASAN_INTERFACE_HOOK(4, write, store)
+ASAN_INTERFACE_HOOK(8, write, store)
+ASAN_INTERFACE_HOOK(16, write, store)
+
+#undef ASAN_INTERFACE_HOOK
+
+// The wide accesses coalesced by XSan are made of 8-byte MOPs, so the first
+// poisoned one is reported as the 8-byte access of the MOP it came from.
+#define ASAN_WIDE_INTERFACE_HOOK(size, operation, asan_operation)   \
+  template <>                                                       \
+  ALWAYS_INLINE void AsanHooks::__xsan_##operation<size>(uptr p) {  \
+    if (LIKELY(AsanQuickCheckForUnpoisonedAccess_<size>(p)))        \
+      return;                                                       \
+    for (uptr cell = p; cell < p + size; cell += 8)                 \
+      __asan_##asan_operation##8(cell);                             \
+  }
+
+ASAN_WIDE_INTERFACE_HOOK(32, read, load)
+ASAN_WIDE_INTERFACE_HOOK(64, read, load)
+ASAN_WIDE_INTERFACE_HOOK(32, write, store)
+ASAN_WIDE_INTERFACE_HOOK(64, write, store)
+
+#undef ASAN_WIDE_INTERFACE_HOOK
+
 }  // namespace __asan
 
 // Register the hooks for Asan.
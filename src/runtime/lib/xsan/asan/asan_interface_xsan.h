@@ -20,8 +20,16 @@ namespace __asan {
 using ::__sanitizer::StackTrace;
 using ::__sanitizer::uptr;
 
-XSAN_MAP_FIELD_FUNC(AsanShadowOffset, kAsanShadowOffset)
-XSAN_MAP_FIELD_FUNC(AsanShadowScale, kAsanShadowScale)
+// The shadow offset is compiled into the instrumented code, so it must not
+// depend on the VMA size.
+static_assert(__xsan::MappingAarch64_39::kAsanShadowOffset ==
+                      __xsan::MappingAarch64_48::kAsanShadowOffset &&
+                  __xsan::MappingAarch64_42::kAsanShadowOffset ==
+                      __xsan::MappingAarch64_48::kAsanShadowOffset,
+              "ASan's shadow offset differs between aarch64 VMA sizes");
+
+XSAN_STATIC_MAP_FIELD_FUNC(AsanShadowOffset, kAsanShadowOffset)
+XSAN_STATIC_MAP_FIELD_FUNC(AsanShadowScale, kAsanShadowScale)
 
 ALWAYS_INLINE uptr AsanShadowGranularity() {
   return (1ULL << AsanShadowScale());
@@ -45,6 +53,21 @@ static inline bool AddressIsPoisoned_(uptr a) {
   return false;
 }
 
+// Return true if the aligned access is unpoisoned judged by the shadow alone,
+// i.e., the fast path of __asan_loadN/__asan_storeN. The wide accesses of 32
+// and 64 bytes coalesced by XSan compare 4 and 8 shadow bytes at once.
+template <u32 AccessSize>
+ALWAYS_INLINE bool AsanQuickCheckForUnpoisonedAccess_(uptr a) {
+  uptr shadow_address = MemToShadow(a);
+  if (AccessSize <= AsanShadowGranularity())
+    return !*reinterpret_cast<const u8 *>(shadow_address);
+  if (AccessSize <= 2 * AsanShadowGranularity())
+    return !*reinterpret_cast<const u16 *>(shadow_address);
+  if (AccessSize <= 4 * AsanShadowGranularity())
+    return !*reinterpret_cast<const u32 *>(shadow_address);
+  return !*reinterpret_cast<const u64 *>(shadow_address);
+}
+
 // Return true if we can quickly decide that the region is unpoisoned.
 // We assume that a redzone is at least 16 bytes.
 static inline bool AsanQuickCheckForUnpoisonedRegion_(uptr beg, uptr size) {
@@ -16,6 +16,19 @@ namespace __msan {
 
 THREADLOCAL MsanThread *MsanThread::msan_current_thread;
 
+/// With XSan's batch_alloc_free_hooks, primary chunks are poisoned when
+/// their region is mapped and when they are recycled, so an allocation does
+/// not need to poison them again.
+static bool AllocationIsPoisoned(void *p) {
+  return ::__xsan::ShouldBatchXsanFreeHook() &&
+         ::__xsan::allocator()->FromPrimary(p);
+}
+
+void MsanHooks::OnAllocatorMap(uptr p, uptr size) {
+  if (::__xsan::ShouldBatchXsanFreeHook())
+    __msan_poison((void *)p, size);
+}
+
 void MsanHooks::OnAllocatorUnmap(uptr p, uptr size) {
   __msan_unpoison((void *)p, size);
 
@@ -29,23 +42,27 @@ void MsanHooks::OnAllocatorUnmap(uptr p, uptr size) {
   }
 }
 
-void MsanHooks::OnXsanAllocHook(uptr ptr, uptr size,
-                                BufferedStackTrace *stack) {
+void MsanHooks::OnXsanAllocHook(uptr ptr, uptr size, BufferedStackTrace *stack,
+                                u32 stack_id) {
   void *allocated = (void *)ptr;
   if (FuncScope<::__xsan::ScopedFunc::calloc>::in_calloc_scope) {
     __msan_unpoison(allocated, size);
-  } else if (flags()->poison_in_malloc) {
+  } else if (flags()->poison_in_malloc && !AllocationIsPoisoned(allocated)) {
     __msan_poison(allocated, size);
     if (__msan_get_track_origins()) {
-      stack->tag = StackTrace::TAG_ALLOC;
-      Origin o = Origin::CreateHeapOrigin(stack);
+      // The allocator tags the stack before putting it into the depot.
+      if (!stack_id)
+        stack->tag = StackTrace::TAG_ALLOC;
+      Origin o = stack_id ? Origin::CreateHeapOrigin(stack_id)
+                          : Origin::CreateHeapOrigin(stack);
       __msan_set_origin(allocated, size, o.raw_id());
     }
   }
   UnpoisonParam(2);
 }
 
-void MsanHooks::OnXsanFreeHook(uptr ptr, uptr size, BufferedStackTrace *stack) {
+void MsanHooks::OnXsanFreeHook(uptr ptr, uptr size, BufferedStackTrace *stack,
+                               u32 stack_id) {
   void *p = (void *)ptr;
   UnpoisonParam(1);
   // This memory will not be reused by anyone else, so we are free to keep it
@@ -54,13 +71,24 @@ void MsanHooks::OnXsanFreeHook(uptr ptr, uptr size, BufferedStackTrace *stack) {
   if (flags()->poison_in_free && ::__xsan::allocator()->FromPrimary(p)) {
     __msan_poison(p, size);
     if (__msan_get_track_origins()) {
-      stack->tag = StackTrace::TAG_DEALLOC;
-      Origin o = Origin::CreateHeapOrigin(stack);
+      if (!stack_id)
+        stack->tag = StackTrace::TAG_DEALLOC;
+      Origin o = stack_id ? Origin::CreateHeapOrigin(stack_id)
+                          : Origin::CreateHeapOrigin(stack);
       __msan_set_origin(p, size, o.raw_id());
     }
   }
 }
 
+bool MsanHooks::RequirePerObjectFreeHook() {
+  return __msan_get_track_origins() || !flags()->poison_in_malloc ||
+         !flags()->poison_in_free;
+}
+
+void MsanHooks::OnXsanRecycleHook(uptr ptr, uptr size) {
+  __msan_poison((void *)ptr, size);
+}
+
 void MsanHooks::OnLibraryLoaded(const char *filename, void *handle) {
 #if SANITIZER_INTERCEPT_DLOPEN_DLCLOSE
   link_map *map = GET_LINK_MAP_BY_DLOPEN_HANDLE((handle));
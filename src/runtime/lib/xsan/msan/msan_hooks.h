@@ -2,6 +2,7 @@
 
 #include "../xsan_hooks_default.h"
 #include "../xsan_hooks_types.h"
+#include "../xsan_simd.h"
 #include "msan_interface_xsan.h"
 #include "msan_thread.h"
 #include "sanitizer_common/sanitizer_errno.h"
@@ -83,10 +84,27 @@ struct MsanHooks : ::__xsan::DefaultHooks<MsanContext, MsanThread> {
     }
     return map_ranges;
   }
+  ALWAYS_INLINE static ArrayRef<__xsan::NamedRange> HotShadowRanges() {
+    static bool initialized = false;
+    static __xsan::NamedRange hot_ranges[2];
+    if (!initialized) {
+      initialized = true;
+      hot_ranges[0] = {{HeapShadowBeg(), HeapShadowEnd()}, "msan shadow heap"};
+      // Origins are only written if origin tracking is on.
+      hot_ranges[1] = {{HeapOriginBeg(), HeapOriginEnd()}, "msan origin heap"};
+    }
+    return ArrayRef<__xsan::NamedRange>(hot_ranges,
+                                        __msan_get_track_origins() ? 2 : 1);
+  }
 
+  static void OnAllocatorMap(uptr p, uptr size);
   static void OnAllocatorUnmap(uptr p, uptr size);
-  static void OnXsanAllocHook(uptr ptr, uptr size, BufferedStackTrace *stack);
-  static void OnXsanFreeHook(uptr ptr, uptr size, BufferedStackTrace *stack);
+  static void OnXsanAllocHook(uptr ptr, uptr size, BufferedStackTrace *stack,
+                              u32 stack_id);
+  static void OnXsanFreeHook(uptr ptr, uptr size, BufferedStackTrace *stack,
+                             u32 stack_id);
+  static bool RequirePerObjectFreeHook();
+  static void OnXsanRecycleHook(uptr ptr, uptr size);
   ALWAYS_INLINE static void OnFakeStackAlloc(uptr addr, uptr size) {
     __sanitizer::internal_memset((void *)MemToShadow(addr), 0xff, size);
   }
@@ -121,6 +139,14 @@ struct MsanHooks : ::__xsan::DefaultHooks<MsanContext, MsanThread> {
   ALWAYS_INLINE static bool RequireStackTraces() {
     return __msan_get_track_origins() > 1;
   }
+  /// Only the origins of the poisoned source bytes are chained with the stack,
+  /// so the copies of initialized data are not unwound at all.
+  ALWAYS_INLINE static bool RequireStackTracesForCopy(const void *src,
+                                                      uptr size) {
+    return RequireStackTraces() &&
+           __xsan::FindFirstNonZeroByte((const u8 *)MemToShadow(src), size) !=
+               size;
+  }
   static int RequireStackTracesSize();
 
   ALWAYS_INLINE static void InitializeFlags() {
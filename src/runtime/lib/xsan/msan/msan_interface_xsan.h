@@ -33,22 +33,28 @@ namespace __msan {
 using ::__sanitizer::StackTrace;
 using ::__sanitizer::uptr;
 
-#define MSAN_MEM_TO_SHADOW(p) ((p) ^ MAP_FIELD(kMSanShadowXor))
+// The formulas are generated along with the mapping, see
+// src/include/platforms/xsan_platform_*.h.
+#define MSAN_MEM_TO_SHADOW(p) (MAP_FIELD(MSanMemToShadow)(p))
 #define MSAN_SHADOW_TO_ORIGIN(p) ((p) + MAP_FIELD(kMSanShadowAdd))
-#define MSAN_MEM_TO_ORIGIN(p) MSAN_SHADOW_TO_ORIGIN(MSAN_MEM_TO_SHADOW(p))
-
-#define MSAN_CVT_FUNC(name, cvt)                              \
-  XSAN_MAP_FUNC(uptr, name, (uptr p), (p)) { return cvt(p); } \
-  template <typename T>                                       \
-  ALWAYS_INLINE uptr name(T p) {                              \
-    return name((uptr)p);                                     \
+#define MSAN_MEM_TO_ORIGIN(p) (MAP_FIELD(MSanMemToOrigin)(p))
+
+// MSan only supports the default mapping (i.e., aarch64_48 on aarch64), see
+// InitializePlatformEarly.
+#define MSAN_CVT_FUNC(name, cvt)                                     \
+  XSAN_STATIC_MAP_FUNC(uptr, name, (uptr p), (p)) { return cvt(p); } \
+  template <typename T>                                              \
+  ALWAYS_INLINE uptr name(T p) {                                     \
+    return name((uptr)p);                                            \
   }
 
 #define MSAN_MAP_BEG(name, field, map) \
-  XSAN_MAP_FUNC_VOID(uptr, name) { return map(MAP_FIELD(field)); }
+  XSAN_STATIC_MAP_FUNC_VOID(uptr, name) { return map(MAP_FIELD(field)); }
 
-#define MSAN_MAP_END(name, field, map) \
-  XSAN_MAP_FUNC_VOID(uptr, name) { return map(MAP_FIELD(field) - 1) + 1; }
+#define MSAN_MAP_END(name, field, map)    \
+  XSAN_STATIC_MAP_FUNC_VOID(uptr, name) { \
+    return map(MAP_FIELD(field) - 1) + 1; \
+  }
 
 MSAN_MAP_BEG(LoShadowBeg, kLoAppMemBeg, MSAN_MEM_TO_SHADOW)
 MSAN_MAP_END(LoShadowEnd, kLoAppMemEnd, MSAN_MEM_TO_SHADOW)
@@ -1 +0,0 @@
-../../../tsan/rtl/tsan_sync.h
\ No newline at end of file
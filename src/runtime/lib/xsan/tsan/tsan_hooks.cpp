@@ -34,10 +34,12 @@ TsanHooks::ScopedPthreadJoin::ScopedPthreadJoin(const int &res,
   auto [thr, pc] = ctx_;
   tid_ = ThreadConsumeTid(thr, pc, (uptr)th);
   ThreadIgnoreBegin(thr, pc);
+  SoleRunnerJoin(thr, tid_);
 }
 
 TsanHooks::ScopedPthreadJoin::~ScopedPthreadJoin() {
   auto [thr, pc] = ctx_;
+  SoleRunnerWake(thr);
   ThreadIgnoreEnd(thr);
   if (res_ == 0) {
     ThreadJoin(thr, pc, tid_);
@@ -256,20 +258,30 @@ TSAN_INTERFACE_HOOK(unaligned_write, 4)
 TSAN_INTERFACE_HOOK(unaligned_write, 8)
 TSAN_INTERFACE_HOOK(unaligned_write, 16)
 
-// Define aligned read hooks
-TSAN_INTERFACE_HOOK(read, 1)
-TSAN_INTERFACE_HOOK(read, 2)
-TSAN_INTERFACE_HOOK(read, 4)
-TSAN_INTERFACE_HOOK(read, 8)
-TSAN_INTERFACE_HOOK(read, 16)
+#undef TSAN_INTERFACE_HOOK
+
+#define TSAN_PERIOD_HOOK(size)                                               \
+  template <>                                                                \
+  void TsanHooks::__xsan_period_read<size>(uptr beg, uptr end, uptr step) {  \
+    if (TSAN_CHECK_GUARD_CONDIITON)                                          \
+      return;                                                                \
+    MemoryAccessPeriodT<size, true>(cur_thread(), GET_CALLER_PC(), beg, end, \
+                                    step);                                   \
+  }                                                                          \
+  template <>                                                                \
+  void TsanHooks::__xsan_period_write<size>(uptr beg, uptr end, uptr step) { \
+    if (TSAN_CHECK_GUARD_CONDIITON)                                          \
+      return;                                                                \
+    MemoryAccessPeriodT<size, false>(cur_thread(), GET_CALLER_PC(), beg,     \
+                                     end, step);                             \
+  }
 
-// Define aligned write hooks
-TSAN_INTERFACE_HOOK(write, 1)
-TSAN_INTERFACE_HOOK(write, 2)
-TSAN_INTERFACE_HOOK(write, 4)
-TSAN_INTERFACE_HOOK(write, 8)
-TSAN_INTERFACE_HOOK(write, 16)
+TSAN_PERIOD_HOOK(1)
+TSAN_PERIOD_HOOK(2)
+TSAN_PERIOD_HOOK(4)
+TSAN_PERIOD_HOOK(8)
+TSAN_PERIOD_HOOK(16)
 
-#undef TSAN_INTERFACE_HOOK
+#undef TSAN_PERIOD_HOOK
 
 }  // namespace __tsan
@@ -5,6 +5,7 @@
 #include "../xsan_hooks_types.h"
 #include "sanitizer_common/sanitizer_platform_limits_posix.h"
 #include "sanitizer_common/sanitizer_stacktrace.h"
+#include "tsan_interface.h"
 #include "tsan_interface_xsan.h"
 #include "tsan_platform.h"
 #include "tsan_rtl_extra.h"
@@ -55,9 +56,21 @@ struct TsanHooks : ::__xsan::DefaultHooks<TsanContext, TsanThread> {
     __xsan::ScopedSanitizerToolName tool_name(name);
     __tsan::TsanInitFromXsanLate();
   }
+  // The indices of the ranges returned by NeededMapRanges.
+  enum MapRangeIndex {
+    kShadowLoApp,
+    kShadowMidApp,
+    kShadowHiApp,
+    kShadowHeap,
+    kMetaLoApp,
+    kMetaMidApp,
+    kMetaHiApp,
+    kMetaHeap,
+    kNumMapRanges
+  };
   ALWAYS_INLINE static ArrayRef<__xsan::NamedRange> NeededMapRanges() {
     static bool initialized = false;
-    static __xsan::NamedRange map_ranges[8];
+    static __xsan::NamedRange map_ranges[kNumMapRanges];
 #define APP2SHADOW(app)                                           \
   {{(uptr)__tsan::MemToShadow(app##MemBeg()),                     \
     (uptr)(__tsan::MemToShadow(app##MemEnd() - 1) + kShadowCnt)}, \
@@ -69,19 +82,30 @@ struct TsanHooks : ::__xsan::DefaultHooks<TsanContext, TsanThread> {
     if (!initialized) {
       // caller is thread safe, so we do not use atomic_bool
       initialized = true;
-      map_ranges[0] = APP2SHADOW(LoApp);
-      map_ranges[1] = APP2SHADOW(MidApp);
-      map_ranges[2] = APP2SHADOW(HiApp);
-      map_ranges[3] = APP2SHADOW(Heap);
-      map_ranges[4] = APP2META(LoApp);
-      map_ranges[5] = APP2META(MidApp);
-      map_ranges[6] = APP2META(HiApp);
-      map_ranges[7] = APP2META(Heap);
+      map_ranges[kShadowLoApp] = APP2SHADOW(LoApp);
+      map_ranges[kShadowMidApp] = APP2SHADOW(MidApp);
+      map_ranges[kShadowHiApp] = APP2SHADOW(HiApp);
+      map_ranges[kShadowHeap] = APP2SHADOW(Heap);
+      map_ranges[kMetaLoApp] = APP2META(LoApp);
+      map_ranges[kMetaMidApp] = APP2META(MidApp);
+      map_ranges[kMetaHiApp] = APP2META(HiApp);
+      map_ranges[kMetaHeap] = APP2META(Heap);
     }
 #undef APP2SHADOW
 #undef APP2META
     return map_ranges;
   }
+  ALWAYS_INLINE static ArrayRef<__xsan::NamedRange> HotShadowRanges() {
+    static bool initialized = false;
+    static __xsan::NamedRange hot_ranges[2];
+    if (!initialized) {
+      initialized = true;
+      auto map_ranges = NeededMapRanges();
+      hot_ranges[0] = map_ranges[kShadowHeap];
+      hot_ranges[1] = map_ranges[kMetaHeap];
+    }
+    return hot_ranges;
+  }
   // ------------------ State-Related Hooks ----------------
   static void EnterSymbolizer() { __tsan::EnterSymbolizer(); }
   static void ExitSymbolizer() { __tsan::ExitSymbolizer(); }
@@ -99,8 +123,14 @@ struct TsanHooks : ::__xsan::DefaultHooks<TsanContext, TsanThread> {
   static void ExitReport();
 
   static void OnAllocatorUnmap(uptr p, uptr size);
-  static void OnXsanAllocHook(uptr ptr, uptr size, BufferedStackTrace *stack);
-  static void OnXsanFreeHook(uptr ptr, uptr size, BufferedStackTrace *stack);
+  static void OnXsanAllocHook(uptr ptr, uptr size, BufferedStackTrace *stack,
+                              u32 stack_id);
+  static void OnXsanFreeHook(uptr ptr, uptr size, BufferedStackTrace *stack,
+                             u32 stack_id);
+  /// The free must be recorded as a write at once, which races with the
+  /// unsynchronized accesses of other threads before it. ASan's quarantine
+  /// does not see those accesses.
+  static bool RequirePerObjectFreeHook() { return true; }
   static void OnXsanAllocFreeTailHook(uptr pc);
   static void OnFakeStackDestroy(uptr addr, uptr size);
   static void OnDtlsAlloc(uptr addr, uptr size);
@@ -237,6 +267,13 @@ struct TsanHooks : ::__xsan::DefaultHooks<TsanContext, TsanThread> {
       return;
     AccessMemoryRange<true>(ctx, offset, size);
   }
+  // TSan records every read in its shadow, whatever the string looks like.
+  PSEUDO_MACRO static void ReadScannedString(const Context *ctx,
+                                             const void *offset, uptr size,
+                                             bool need_check,
+                                             const char *func_name) {
+    ReadRange(ctx, offset, size, func_name);
+  }
   PSEUDO_MACRO static void WriteRange(const Context *ctx, const void *offset,
                                       uptr size, const char *func_name) {
     if (TSAN_CHECK_GUARD_CONDIITON)
@@ -266,6 +303,11 @@ struct TsanHooks : ::__xsan::DefaultHooks<TsanContext, TsanThread> {
     WriteRange(&ctx, offset, size, func_name);
   }
   // ---------- Xsan-Interface-Related Hooks ----------------
+  ALWAYS_INLINE static void PrefetchShadow(uptr p) {
+    if (TSAN_CHECK_GUARD_CONDIITON)
+      return;
+    __builtin_prefetch(__tsan::MemToShadow(p));
+  }
   template <u32 ReadSize>
   static void __xsan_unaligned_read(uptr p);
   template <u32 WriteSize>
@@ -274,6 +316,10 @@ struct TsanHooks : ::__xsan::DefaultHooks<TsanContext, TsanThread> {
   static void __xsan_read(uptr p);
   template <u32 WriteSize>
   static void __xsan_write(uptr p);
+  template <u32 ReadSize>
+  static void __xsan_period_read(uptr beg, uptr end, uptr step);
+  template <u32 WriteSize>
+  static void __xsan_period_write(uptr beg, uptr end, uptr step);
   // ---------- Func to use special scope ------------------------
   template <__xsan::ScopedFunc func>
   struct FuncScope {};
@@ -291,6 +337,47 @@ struct TsanHooks : ::__xsan::DefaultHooks<TsanContext, TsanThread> {
   };
 };
 
+// The aligned hooks are inlined into the fused access check in xsan_hooks.h,
+// leaving __tsan_readN/__tsan_writeN as the only call per access.
+#define TSAN_INTERFACE_HOOK(operation_type, size)                       \
+  template <>                                                           \
+  ALWAYS_INLINE void TsanHooks::__xsan_##operation_type<size>(uptr p) { \
+    __tsan_##operation_type##size((void *)p);                           \
+  }
+
+TSAN_INTERFACE_HOOK(read, 1)
+TSAN_INTERFACE_HOOK(read, 2)
+TSAN_INTERFACE_HOOK(read, 4)
+TSAN_INTERFACE_HOOK(read, 8)
+TSAN_INTERFACE_HOOK(read, 16)
+
+TSAN_INTERFACE_HOOK(write, 1)
+TSAN_INTERFACE_HOOK(write, 2)
+TSAN_INTERFACE_HOOK(write, 4)
+TSAN_INTERFACE_HOOK(write, 8)
+TSAN_INTERFACE_HOOK(write, 16)
+
+#undef TSAN_INTERFACE_HOOK
+
+// The wide accesses coalesced by XSan are made of whole 8-byte MOPs, so each
+// shadow cell is accessed as a whole, as those MOPs did, and the race reports
+// stay the same. The cells are checked as a period of 8-byte accesses, whose
+// duplicates only cost a vector compare.
+#define TSAN_WIDE_INTERFACE_HOOK(operation_type, size, is_read)         \
+  template <>                                                           \
+  ALWAYS_INLINE void TsanHooks::__xsan_##operation_type<size>(uptr p) { \
+    TSAN_CHECK_GUARD(p)                                                 \
+    MemoryAccessPeriodT<kShadowCell, is_read>(                          \
+        cur_thread(), GET_CALLER_PC(), p, p + size, kShadowCell);       \
+  }
+
+TSAN_WIDE_INTERFACE_HOOK(read, 32, true)
+TSAN_WIDE_INTERFACE_HOOK(read, 64, true)
+TSAN_WIDE_INTERFACE_HOOK(write, 32, false)
+TSAN_WIDE_INTERFACE_HOOK(write, 64, false)
+
+#undef TSAN_WIDE_INTERFACE_HOOK
+
 }  // namespace __tsan
 
 // Register the hooks for Tsan.
@@ -547,6 +547,8 @@ static void SetJmp(ThreadState *thr, uptr sp) {
 }
 
 static void LongJmp(ThreadState *thr, uptr *env) {
+  // A signal handler may jump out of pthread_join.
+  SoleRunnerWake(thr);
   uptr sp = ExtractLongJmpSp(env);
   // Find the saved buf with matching sp.
   for (uptr i = 0; i < thr->jmp_bufs.Size(); i++) {
@@ -2053,6 +2055,10 @@ void sighandler(int sig, __sanitizer_siginfo *info, void *ctx) {
     atomic_fetch_add(&thr->in_signal_handler, 1, memory_order_relaxed);
     if (atomic_load(&thr->in_blocking_func, memory_order_relaxed)) {
       atomic_store(&thr->in_blocking_func, 0, memory_order_relaxed);
+      // The handler runs user code next to the sole runner without any
+      // ordering with the accesses it elided.
+      if (thr->sole_runner_join_target)
+        SoleRunnerDisable();
       CallUserSignalHandler(thr, sync, true, sig, info, ctx);
       atomic_store(&thr->in_blocking_func, 1, memory_order_relaxed);
     } else {
@@ -2172,6 +2178,8 @@ void atfork_child() {
   ThreadState *thr = cur_thread();
   const uptr pc = StackTrace::GetCurrentPc();
   ForkChildAfter(thr, pc, true);
+  // Only the forking thread survives in the child.
+  SoleRunnerReset();
   FdOnFork(thr, pc);
 }
 }  // namespace __tsan
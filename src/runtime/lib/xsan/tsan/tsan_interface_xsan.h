@@ -17,6 +17,11 @@ ThreadState *cur_thread_init();
 // This creates 2 non-inlined specialized versions of MemoryAccessRange.
 template <bool is_read>
 void MemoryAccessRangeT(ThreadState *thr, uptr pc, uptr addr, uptr size);
+// Periodic accesses {addr + k * step | addr + k * step < end}, defined in
+// tsan_interface.inc to inline the shadow checks of MemoryAccess.
+template <uptr size, bool is_read>
+void MemoryAccessPeriodT(ThreadState *thr, uptr pc, uptr addr, uptr end,
+                         uptr step);
 
 void InitializeFlags();
 void InitializeInterceptors();
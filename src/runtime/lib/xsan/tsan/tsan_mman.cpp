@@ -211,7 +211,6 @@ void *user_alloc_internal(ThreadState *thr, uptr pc, uptr sz, uptr align,
 
 void user_free(ThreadState *thr, uptr pc, void *p, bool signal) {
   /// Call from tsan_fd.cpp
-  ScopedGlobalProcessor sgp;
   BufferedStackTrace stack;
   stack.Init(thr->shadow_stack, thr->shadow_stack_pos - thr->shadow_stack, pc);
   __xsan::allocator()->DeallocateInternal(p, &stack);
@@ -263,16 +262,25 @@ void OnUserAlloc(ThreadState *thr, uptr pc, uptr p, uptr sz, bool write) {
     MemoryResetRange(thr, pc, (uptr)p, sz);
 }
 
+/// Modified: threads without a Processor (see ScopedGlobalProcessor) free the
+/// meta objects through MetaMap::FreeBlockNoProc instead of serializing on the
+/// global Processor.
+static uptr FreeMetaBlock(ThreadState *thr, uptr p, bool reset) {
+  if (LIKELY(thr->proc()))
+    return ctx->metamap.FreeBlock(thr->proc(), p, reset);
+  return ctx->metamap.FreeBlockNoProc(p, reset);
+}
+
 void OnUserFree(ThreadState *thr, uptr pc, uptr p, bool write) {
   CHECK_NE(p, (void*)0);
   if (!thr->slot) {
     // Very early/late in thread lifetime, or during fork.
-    UNUSED uptr sz = ctx->metamap.FreeBlock(thr->proc(), p, false);
+    UNUSED uptr sz = FreeMetaBlock(thr, p, false);
     DPrintf("#%d: free(0x%zx, %zu) (no slot)\n", thr->tid, p, sz);
     return;
   }
   SlotLocker locker(thr);
-  uptr sz = ctx->metamap.FreeBlock(thr->proc(), p, true);
+  uptr sz = FreeMetaBlock(thr, p, true);
   DPrintf("#%d: free(0x%zx, %zu)\n", thr->tid, p, sz);
   if (write && thr->ignore_reads_and_writes == 0)
     MemoryRangeFreed(thr, pc, (uptr)p, sz);
@@ -432,18 +440,20 @@ void TsanHooks::OnAllocatorUnmap(uptr p, uptr size) {
   cb.OnUnmap(p, size);
 }
 
-void TsanHooks::OnXsanAllocHook(uptr ptr, uptr size, BufferedStackTrace *stack) {
+void TsanHooks::OnXsanAllocHook(uptr ptr, uptr size, BufferedStackTrace *stack,
+                                u32 stack_id) {
   if (__tsan::is_tsan_initialized()) {
     /// TODO: remove code related to tsan's uaf checking
     __tsan::OnUserAlloc(__tsan::cur_thread(), stack->trace[0], ptr, size, true);
   }
 }
 
-void TsanHooks::OnXsanFreeHook(uptr ptr, uptr size, BufferedStackTrace *stack) {
+void TsanHooks::OnXsanFreeHook(uptr ptr, uptr size, BufferedStackTrace *stack,
+                               u32 stack_id) {
   /// XSanThread is set as nullptr in TSD destructor.
   /// pthread_deattach makes TSD destructor run before free.
-  /// Hence, we need to add a fallback, just like ASan's `if(!t)` or TSan's
-  /// `ScopedGlobalProcessor`
+  /// Hence, the thread may have no Processor here, which OnUserFree handles
+  /// without the global Processor (see FreeMetaBlock).
   if (__tsan::is_tsan_initialized()) {
     /// TODO: remove code related to tsan's uaf checking
     __tsan::OnUserFree(__tsan::cur_thread(), stack->trace[0], ptr, true);
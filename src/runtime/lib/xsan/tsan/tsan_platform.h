@@ -181,6 +181,7 @@ C/C++ on linux/aarch64 (39-bit VMA)
 7d00 0000 00 - 7fff ffff ff: modules and main thread stack  (12 GB)
 */
 
+/// Modified: generated with ASan's shadow, see xsan_platform_aarch64_39.h.
 using MappingAarch64_39 = TsanMapping<__xsan::MappingAarch64_39>;
 // struct MappingAarch64_39 {
 //   static const uptr kLoAppMemBeg   = 0x0000001000ull;
@@ -214,6 +215,7 @@ C/C++ on linux/aarch64 (42-bit VMA)
 3f000 0000 00 - 3ffff ffff ff: modules and main thread stack  (64 GB)
 */
 
+/// Modified: generated with ASan's shadow, see xsan_platform_aarch64_42.h.
 using MappingAarch64_42 = TsanMapping<__xsan::MappingAarch64_42>;
 // struct MappingAarch64_42 {
 //   static const uptr kLoAppMemBeg   = 0x00000001000ull;
@@ -729,7 +731,9 @@ struct MappingGoS390x {
   static const uptr kShadowAdd = 0x400000000000ull;
 };
 
-extern uptr vmaSize;
+/// Modified: shared with XSan, which selects its mappings by the same value.
+/// Set by TSan's InitializePlatformEarly (see TsanHooks::InitFromXsanEarly).
+using __xsan::vmaSize;
 
 template <typename Func, typename Arg>
 ALWAYS_INLINE auto SelectMapping(Arg arg) {
@@ -760,14 +764,21 @@ ALWAYS_INLINE auto SelectMapping(Arg arg) {
 #  elif defined(__x86_64__) || SANITIZER_APPLE
   return Func::template Apply<Mapping48AddressSpace>(arg);
 #  elif defined(__aarch64__)
+/// Modified: only the VMA sizes down to XSAN_AARCH64_MIN_VMA are supported.
+#    if XSAN_AARCH64_MIN_VMA < 48
   switch (vmaSize) {
+#      if XSAN_AARCH64_MIN_VMA <= 39
     case 39:
       return Func::template Apply<MappingAarch64_39>(arg);
+#      endif
     case 42:
       return Func::template Apply<MappingAarch64_42>(arg);
     case 48:
       return Func::template Apply<MappingAarch64_48>(arg);
   }
+#    else
+  return Func::template Apply<MappingAarch64_48>(arg);
+#    endif
 #  elif SANITIZER_LOONGARCH64
   return Func::template Apply<MappingLoongArch64_47>(arg);
 #  elif defined(__powerpc64__)
@@ -954,11 +965,6 @@ struct MemToShadowImpl {
   }
 };
 
-ALWAYS_INLINE
-RawShadow *MemToShadow(uptr x) {
-  return reinterpret_cast<RawShadow *>(SelectMapping<MemToShadowImpl>(x));
-}
-
 struct MemToMetaImpl {
   template <typename Mapping>
   static u32 *Apply(uptr x) {
@@ -969,6 +975,42 @@ struct MemToMetaImpl {
   }
 };
 
+// XSan's mappings come with generated formulas, which share the base operation
+// with MSan's (see kFusedShadowBase), so that it is computed once if both
+// sanitizers check the same address.
+static_assert(kShadowCell == 8 && kShadowMultiplier == 2 &&
+                  kMetaShadowCell == 8 && kMetaShadowSize == 4,
+              "update the TSan parameters in gen_mapping_via_z3.py");
+
+template <>
+inline uptr MemToShadowImpl::Apply<Mapping48AddressSpace>(uptr x) {
+  DCHECK(IsAppMemImpl::Apply<Mapping48AddressSpace>(x));
+  return Mapping48AddressSpace::TsanMemToShadow(x);
+}
+
+template <>
+inline uptr MemToShadowImpl::Apply<MappingAarch64_48>(uptr x) {
+  DCHECK(IsAppMemImpl::Apply<MappingAarch64_48>(x));
+  return MappingAarch64_48::TsanMemToShadow(x);
+}
+
+template <>
+inline u32 *MemToMetaImpl::Apply<Mapping48AddressSpace>(uptr x) {
+  DCHECK(IsAppMemImpl::Apply<Mapping48AddressSpace>(x));
+  return (u32 *)Mapping48AddressSpace::TsanMemToMeta(x);
+}
+
+template <>
+inline u32 *MemToMetaImpl::Apply<MappingAarch64_48>(uptr x) {
+  DCHECK(IsAppMemImpl::Apply<MappingAarch64_48>(x));
+  return (u32 *)MappingAarch64_48::TsanMemToMeta(x);
+}
+
+ALWAYS_INLINE
+RawShadow *MemToShadow(uptr x) {
+  return reinterpret_cast<RawShadow *>(SelectMapping<MemToShadowImpl>(x));
+}
+
 ALWAYS_INLINE
 u32 *MemToMeta(uptr x) { return SelectMapping<MemToMetaImpl>(x); }
 
@@ -86,9 +86,6 @@ static void InitializeLongjmpXorKey();
 static uptr longjmp_xor_key;
 #endif
 
-// Runtime detected VMA size.
-uptr vmaSize;
-
 enum {
   MemTotal,
   MemShadow,
@@ -225,6 +225,12 @@ struct alignas(SANITIZER_CACHE_LINE_SIZE) ThreadState {
   // vfork child process (vfork child process can invoke no system calls but
   // `exit`/`exec`).
   bool in_vfork_child;
+  // Set if the thread is counted in NumRunningThreads, i.e., it was created
+  // by a tracked thread or is the main thread (see tsan_sole_runner_elision).
+  bool sole_runner_counted = false;
+  // The thread being joined while this thread is parked in pthread_join and
+  // is not counted in NumRunningThreads.
+  ThreadContext *sole_runner_join_target = nullptr;
   const Tid tid;
   uptr stk_addr;
   uptr stk_size;
@@ -298,6 +304,14 @@ class ThreadContext final : public ThreadContextBase {
   VectorClock *sync;
   uptr sync_epoch;
   Trace trace;
+  // The parked joiner that takes over the slot of this thread in
+  // NumRunningThreads when it finishes, and whether it has finished.
+  // Guarded by the sole-runner mutex (see tsan_sole_runner_elision).
+  ThreadState *sole_runner_joiner;
+  bool sole_runner_finished;
+  // Set if the thread finished with no parked joiner, so that it keeps its
+  // slot until ThreadJoin has acquired its clock.
+  bool sole_runner_slot_held;
 
   // Override superclass callbacks.
   void OnDead() override;
@@ -71,6 +71,139 @@ void EnableMainThreadTsan(ThreadState *thr) {
   StoreCurrentTsanState(thr);
 }
 
+atomic_uint32_t NumRunningThreads;
+atomic_uint64_t SoleRunnerElidedAccesses;
+// Number of times the process entered a period with a sole runner.
+static atomic_uint64_t sole_runner_periods;
+// Orders parking in pthread_join against the exit of the joined thread.
+static StaticSpinMutex sole_runner_mtx;
+// Added to NumRunningThreads to keep it off 1 for the rest of the process.
+static const u32 kSoleRunnerDisabledBias = 1 << 16;
+// Number of finished threads that keep their slot until they are joined.
+static atomic_uint32_t sole_runner_held_slots;
+
+static void SoleRunnerLeave() {
+  if (atomic_fetch_sub(&NumRunningThreads, 1, memory_order_relaxed) == 2)
+    atomic_fetch_add(&sole_runner_periods, 1, memory_order_relaxed);
+}
+
+void SoleRunnerDisable() {
+  atomic_fetch_add(&NumRunningThreads, kSoleRunnerDisabledBias,
+                   memory_order_relaxed);
+}
+
+bool SoleRunnerElidesSlow() {
+  // A thread the runtime never counted may run next to the sole runner.
+  if (UNLIKELY(!cur_thread()->sole_runner_counted)) {
+    SoleRunnerDisable();
+    return false;
+  }
+  // Only the sole runner gets here, so a lost update is harmless.
+  atomic_store_relaxed(&SoleRunnerElidedAccesses,
+                       atomic_load_relaxed(&SoleRunnerElidedAccesses) + 1);
+  return true;
+}
+
+void SoleRunnerJoin(ThreadState *thr, Tid tid) {
+  if (!__xsan::flags()->tsan_sole_runner_elision || !thr->sole_runner_counted ||
+      thr->sole_runner_join_target || tid == kInvalidTid)
+    return;
+  ThreadContext *target;
+  {
+    ThreadRegistryLock l(&ctx->thread_registry);
+    target = static_cast<ThreadContext *>(
+        ctx->thread_registry.GetThreadLocked(tid));
+  }
+  // The joiner holds the tid, so the context is not reused meanwhile.
+  SpinMutexLock l(&sole_runner_mtx);
+  if (!target || target == thr->tctx || target->sole_runner_finished ||
+      target->sole_runner_joiner)
+    return;
+  target->sole_runner_joiner = thr;
+  thr->sole_runner_join_target = target;
+  SoleRunnerLeave();
+}
+
+void SoleRunnerWake(ThreadState *thr) {
+  if (!thr->sole_runner_join_target)
+    return;
+  SpinMutexLock l(&sole_runner_mtx);
+  ThreadContext *target = thr->sole_runner_join_target;
+  thr->sole_runner_join_target = nullptr;
+  // The finished target has already handed its slot over to this thread.
+  if (target->sole_runner_joiner != thr)
+    return;
+  // Woken before the target finished, e.g., by a longjmp out of a signal
+  // handler or a cancellation. Nothing orders the accesses elided meanwhile
+  // before the ones of this thread.
+  target->sole_runner_joiner = nullptr;
+  atomic_fetch_add(&NumRunningThreads, 1 + kSoleRunnerDisabledBias,
+                   memory_order_relaxed);
+}
+
+void SoleRunnerThreadCreate() {
+  // Called by the running parent before the child runs any user code, so the
+  // parent stops eliding before the child can access memory.
+  if (__xsan::flags()->tsan_sole_runner_elision)
+    atomic_fetch_add(&NumRunningThreads, 1, memory_order_relaxed);
+}
+
+void SoleRunnerThreadStart(ThreadState *thr) {
+  if (!__xsan::flags()->tsan_sole_runner_elision)
+    return;
+  // Threads without a parent other than the main one, e.g., GCD workers, were
+  // not counted by SoleRunnerThreadCreate.
+  if (thr->tid == kMainTid || thr->tctx->parent_tid != kInvalidTid)
+    thr->sole_runner_counted = true;
+  else
+    SoleRunnerDisable();
+}
+
+void SoleRunnerThreadFinish(ThreadState *thr) {
+  if (!__xsan::flags()->tsan_sole_runner_elision || !thr->sole_runner_counted)
+    return;
+  // A thread cancelled in pthread_join is still parked.
+  SoleRunnerWake(thr);
+  thr->sole_runner_counted = false;
+  SpinMutexLock l(&sole_runner_mtx);
+  thr->tctx->sole_runner_finished = true;
+  // The joiner acquires the clock of this thread in ThreadJoin before it
+  // touches any memory, so it may keep the slot.
+  if (thr->tctx->sole_runner_joiner) {
+    thr->tctx->sole_runner_joiner = nullptr;
+    return;
+  }
+  // Nothing orders the accesses of this thread before the ones of the threads
+  // still running until one of them joins it, so keep the slot until then.
+  // Detached threads never give it back.
+  thr->tctx->sole_runner_slot_held = true;
+  atomic_fetch_add(&sole_runner_held_slots, 1, memory_order_relaxed);
+}
+
+void SoleRunnerThreadJoined() {
+  atomic_fetch_sub(&sole_runner_held_slots, 1, memory_order_relaxed);
+  SoleRunnerLeave();
+}
+
+void SoleRunnerReset() {
+  if (!__xsan::flags()->tsan_sole_runner_elision)
+    return;
+  // The finished threads may still be joined in the child.
+  atomic_store_relaxed(&NumRunningThreads,
+                       1 + atomic_load_relaxed(&sole_runner_held_slots));
+  atomic_fetch_add(&sole_runner_periods, 1, memory_order_relaxed);
+}
+
+void PrintSoleRunnerStats() {
+  if (!__xsan::flags()->tsan_sole_runner_elision)
+    return;
+  VPrintf(1,
+          "ThreadSanitizer: sole-runner elision: %llu accesses elided in "
+          "%llu periods\n",
+          (unsigned long long)atomic_load_relaxed(&SoleRunnerElidedAccesses),
+          (unsigned long long)atomic_load_relaxed(&sole_runner_periods));
+}
+
 ScopedIgnoreTsan::ScopedIgnoreTsan(bool enable) : enable_(enable) {
 #if !SANITIZER_GO
   if (enable_) {
@@ -6,6 +6,7 @@
 
 #include "sanitizer_common/sanitizer_allocator_interface.h"
 #include "sanitizer_common/sanitizer_asm.h"
+#include "sanitizer_common/sanitizer_atomic.h"
 
 namespace __tsan {
 struct ThreadState;
@@ -41,6 +42,51 @@ void RestoreTsanState(ThreadState *thr);
 
 extern bool MainThreadTsanDisabled;
 
+/// Sole-runner elision (tsan_sole_runner_elision):
+/// The number of counted threads that are not parked in pthread_join.
+/// Only maintained if the flag is set, so it never reads 1 otherwise.
+/// Whichever thread runs while it reads 1 is the sole runner and skips the
+/// race checks, as nothing else can touch the memory concurrently.
+/// The elided accesses leave no trace in the shadow, so every thread that
+/// runs afterwards must be ordered after them by a vector clock edge:
+///   - a thread created by the sole runner acquires its clock in ThreadStart;
+///   - a parked joiner only takes a slot again when the thread it joins
+///     finishes, and acquires the clock of that thread in ThreadJoin. As the
+///     thread it joins was running or parked itself, this covers whichever
+///     thread ran alone meanwhile.
+/// Conversely, a thread that finishes with no parked joiner keeps its slot
+/// until ThreadJoin has acquired its clock, so the survivors do not elide
+/// accesses that may race with its own. Detached threads never give it back.
+/// Any other wake-up (a signal handler on a parked thread, a longjmp out of
+/// pthread_join, a thread the runtime did not count) disables the elision for
+/// the rest of the process, as the accesses elided so far may race unseen.
+extern atomic_uint32_t NumRunningThreads;
+extern atomic_uint64_t SoleRunnerElidedAccesses;
+
+bool SoleRunnerElidesSlow();
+
+ALWAYS_INLINE bool SoleRunnerElides() {
+  if (LIKELY(atomic_load_relaxed(&NumRunningThreads) != 1))
+    return false;
+  return SoleRunnerElidesSlow();
+}
+
+/// Park the thread before it blocks in pthread_join on the thread `tid`, or
+/// wake it if it leaves pthread_join before that thread finished.
+void SoleRunnerJoin(ThreadState *thr, Tid tid);
+void SoleRunnerWake(ThreadState *thr);
+/// Stop eliding for the rest of the process.
+void SoleRunnerDisable();
+/// Account the creation/start/exit of a thread, or reset the counter in a
+/// fork child.
+void SoleRunnerThreadCreate();
+void SoleRunnerThreadStart(ThreadState *thr);
+void SoleRunnerThreadFinish(ThreadState *thr);
+/// Give back the slot a finished thread kept until it was joined.
+void SoleRunnerThreadJoined();
+void SoleRunnerReset();
+void PrintSoleRunnerStats();
+
 #if SANITIZER_DEBUG
 #  define TSAN_ADDR_GUARD_CONDITION(addr) (!IsAppMem((uptr)(addr)))
 #else
@@ -51,8 +97,9 @@ extern bool MainThreadTsanDisabled;
 //   - Check : should be disabled when all sub-threads are joined
 //   - Store : should be disabled when in single thread
 
-#define TSAN_CHECK_GUARD_CONDIITON \
-  (MainThreadTsanDisabled /* Fast Version of thr->fast_state.GetIgnoreBit()*/)
+#define TSAN_CHECK_GUARD_CONDIITON                                           \
+  (MainThreadTsanDisabled /* Fast Version of thr->fast_state.GetIgnoreBit()*/ \
+   || SoleRunnerElides())
 
 /// FIXME: Shall we really need to guard the metatdata store?
 /// StoreShadow is just one atomic operation, while TraceAccess is
@@ -24,7 +24,13 @@ namespace __tsan {
 
 // ThreadContext implementation.
 
-ThreadContext::ThreadContext(Tid tid) : ThreadContextBase(tid), thr(), sync() {}
+ThreadContext::ThreadContext(Tid tid)
+    : ThreadContextBase(tid),
+      thr(),
+      sync(),
+      sole_runner_joiner(),
+      sole_runner_finished(),
+      sole_runner_slot_held() {}
 
 #if !SANITIZER_GO
 ThreadContext::~ThreadContext() {
@@ -100,6 +106,7 @@ void ThreadFinalize(ThreadState *thr) {
       !__xsan::flags()->tsan_ignore_runtime) {
     EnableMainThreadTsan(thr);
   }
+  PrintSoleRunnerStats();
   ThreadCheckIgnore(thr);
 #if !SANITIZER_GO
   if (!ShouldReport(thr, ReportTypeThreadLeak))
@@ -136,6 +143,7 @@ Tid ThreadCreate(ThreadState *thr, uptr pc, uptr uid, bool detached) {
   if (thr) {
     atomic_fetch_add(&ctx->num_alive_threads, 1, memory_order_relaxed);
     atomic_fetch_add(&ctx->num_unjoined_threads, 1, memory_order_relaxed);
+    SoleRunnerThreadCreate();
     /* Sub-Threads Creation */
     // if tsan_ignore_runtime is true, we disable main thread TSan for all time.
     if (support_single_thread_optimization(thr) &&
@@ -154,6 +162,7 @@ Tid ThreadCreate(ThreadState *thr, uptr pc, uptr uid, bool detached) {
     /* Main Thread Creation */
     atomic_store_relaxed(&ctx->num_alive_threads, 1);
     atomic_store_relaxed(&ctx->num_unjoined_threads, 1);
+    SoleRunnerReset();
 
     // Delay to ThreadStart, as some settings of thr rely on thr->ignore_sync
     // being false.
@@ -172,6 +181,9 @@ void ThreadContext::OnCreated(void *arg) {
   sync = args->sync;
   sync_epoch = args->sync_epoch;
   creation_stack_id = args->stack;
+  sole_runner_joiner = nullptr;
+  sole_runner_finished = false;
+  sole_runner_slot_held = false;
 }
 
 extern "C" void __tsan_stack_initialization() {}
@@ -214,6 +226,7 @@ void ThreadStart(ThreadState *thr, Tid tid, tid_t os_id,
 #if !SANITIZER_GO
   thr->is_inited = true;
 #endif
+  SoleRunnerThreadStart(thr);
 
   uptr stk_addr = 0;
   uptr stk_end = 0;
@@ -284,6 +297,7 @@ void ThreadState::DestroyThreadState() {
 void ThreadFinish(ThreadState *thr) {
   DPrintf("#%d: ThreadFinish\n", thr->tid);
   atomic_fetch_sub(&ctx->num_alive_threads, 1, memory_order_relaxed);
+  SoleRunnerThreadFinish(thr);
   ThreadCheckIgnore(thr);
   if (thr->stk_addr && thr->stk_size)
     DontNeedShadowFor(thr->stk_addr, thr->stk_size);
@@ -359,6 +373,7 @@ Tid ThreadConsumeTid(ThreadState *thr, uptr pc, uptr uid) {
 struct JoinArg {
   VectorClock *sync;
   uptr sync_epoch;
+  bool sole_runner_slot_held;
 };
 
 void ThreadJoin(ThreadState *thr, uptr pc, Tid tid) {
@@ -372,6 +387,9 @@ void ThreadJoin(ThreadState *thr, uptr pc, Tid tid) {
       thr->clock.Acquire(arg.sync);
   }
   Free(arg.sync);
+  // The accesses of the joined thread are now ordered before ours.
+  if (arg.sole_runner_slot_held)
+    SoleRunnerThreadJoined();
   atomic_fetch_sub(&ctx->num_unjoined_threads, 1, memory_order_relaxed);
   if (support_single_thread_optimization(thr) && is_now_all_joined()) {
     DisableMainThreadTsan(thr);
@@ -384,6 +402,8 @@ void ThreadContext::OnJoined(void *ptr) {
   arg->sync_epoch = sync_epoch;
   sync = nullptr;
   sync_epoch = 0;
+  arg->sole_runner_slot_held = sole_runner_slot_held;
+  sole_runner_slot_held = false;
 }
 
 void ThreadContext::OnDead() { CHECK_EQ(sync, nullptr); }
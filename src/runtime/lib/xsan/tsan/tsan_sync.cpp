@@ -68,7 +68,27 @@ uptr MetaMap::FreeBlock(Processor *proc, uptr p, bool reset) {
   return sz;
 }
 
+uptr MetaMap::FreeBlockNoProc(uptr p, bool reset) {
+  MBlock* b = GetBlock(p);
+  if (b == 0)
+    return 0;
+  uptr sz = RoundUpTo(b->siz, kMetaShadowCell);
+  DenseSlabAllocCache block_cache, sync_cache;
+  block_alloc_.InitCache(&block_cache);
+  sync_alloc_.InitCache(&sync_cache);
+  FreeRange(&block_cache, &sync_cache, p, sz, reset);
+  block_alloc_.FlushCache(&block_cache);
+  sync_alloc_.FlushCache(&sync_cache);
+  return sz;
+}
+
 bool MetaMap::FreeRange(Processor *proc, uptr p, uptr sz, bool reset) {
+  return FreeRange(&proc->block_cache, &proc->sync_cache, p, sz, reset);
+}
+
+bool MetaMap::FreeRange(DenseSlabAllocCache *block_cache,
+                        DenseSlabAllocCache *sync_cache, uptr p, uptr sz,
+                        bool reset) {
   bool has_something = false;
   u32 *meta = MemToMeta(p);
   u32 *end = MemToMeta(p + sz);
@@ -84,7 +104,7 @@ bool MetaMap::FreeRange(Processor *proc, uptr p, uptr sz, bool reset) {
     has_something = true;
     while (idx != 0) {
       if (idx & kFlagBlock) {
-        block_alloc_.Free(&proc->block_cache, idx & ~kFlagMask);
+        block_alloc_.Free(block_cache, idx & ~kFlagMask);
         break;
       } else if (idx & kFlagSync) {
         DCHECK(idx & kFlagSync);
@@ -92,7 +112,7 @@ bool MetaMap::FreeRange(Processor *proc, uptr p, uptr sz, bool reset) {
         u32 next = s->next;
         if (reset)
           s->Reset();
-        sync_alloc_.Free(&proc->sync_cache, idx & ~kFlagMask);
+        sync_alloc_.Free(sync_cache, idx & ~kFlagMask);
         idx = next;
       } else {
         CHECK(0);
@@ -12,60 +12,17 @@
 
 #include "asan/asan_allocator.h"
 
-#if XSAN_CONTAINS_TSAN
-namespace __tsan {
-struct ScopedGlobalProcessor {
-  ScopedGlobalProcessor();
-  ~ScopedGlobalProcessor();
-};
-}  // namespace __tsan
-#endif
 namespace __xsan {
 
 void xsan_free(void *ptr, BufferedStackTrace *stack, AllocType alloc_type) {
-  /// Refer to `tsan_mman.cpp:user_free`
-  /// TODO: maybe could be eliminated, as ASan does similar handling as follows
-  /*
-    AsanThread *t = GetCurrentThread();
-    void *allocated;
-    if (t) {
-      AllocatorCache *cache = GetAllocatorCache(&t->malloc_storage());
-      allocated =
-          allocator.Allocate(cache, needed_size, __xsan::kDefaultAlignment);
-    } else {
-      SpinMutexLock l(&fallback_mutex);
-      AllocatorCache *cache = &fallback_allocator_cache;
-      allocated =
-          allocator.Allocate(cache, needed_size, __xsan::kDefaultAlignment);
-    }
-  */
-#if XSAN_CONTAINS_TSAN
-  __tsan::ScopedGlobalProcessor sgp;
-#endif
+  /// No global TSan Processor is wired here: ASan falls back to its own
+  /// caches for threads without AsanThread, and TSan frees the meta objects
+  /// lock-free for threads without Processor (see `tsan_mman.cpp:OnUserFree`).
   __asan::asan_free(ptr, stack, alloc_type);
 }
 
 void xsan_delete(void *ptr, uptr size, uptr alignment,
                  BufferedStackTrace *stack, AllocType alloc_type) {
-  /// Refer to `tsan_mman.cpp:user_free`
-  /// TODO: maybe could be eliminated, as ASan does similar handling as follows
-  /*
-    AsanThread *t = GetCurrentThread();
-    void *allocated;
-    if (t) {
-      AllocatorCache *cache = GetAllocatorCache(&t->malloc_storage());
-      allocated =
-          allocator.Allocate(cache, needed_size, __xsan::kDefaultAlignment);
-    } else {
-      SpinMutexLock l(&fallback_mutex);
-      AllocatorCache *cache = &fallback_allocator_cache;
-      allocated =
-          allocator.Allocate(cache, needed_size, __xsan::kDefaultAlignment);
-    }
-  */
-#if XSAN_CONTAINS_TSAN
-  __tsan::ScopedGlobalProcessor sgp;
-#endif
   __asan::asan_delete(ptr, size, alignment, stack, alloc_type);
 }
 
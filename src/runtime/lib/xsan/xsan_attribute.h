@@ -1,3 +1,7 @@
 #pragma once
 
 #define PSEUDO_MACRO __attribute__((nodebug, always_inline)) inline
+
+/// For hot hooks on the interceptor path: inlines every call in the body that
+/// the compiler can see, i.e., the whole per-sanitizer fan-out.
+#define XSAN_FLATTEN __attribute__((flatten))
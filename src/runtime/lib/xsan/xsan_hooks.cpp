@@ -28,9 +28,8 @@ using namespace __xsan;
 // ---------------------- State/Ignoration Management Hooks --------------------
 namespace __xsan {
 
-THREADLOCAL int xsan_in_internal = 0;
-THREADLOCAL int is_in_symbolizer = 0;
-THREADLOCAL int xsan_in_unwind = 0;
+alignas(SANITIZER_CACHE_LINE_SIZE) THREADLOCAL XsanThreadState
+    xsan_thread_state;
 
 int get_exit_code(const void *ctx) {
   int exit_code = 0;
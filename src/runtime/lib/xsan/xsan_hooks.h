@@ -12,8 +12,10 @@
 #include <sanitizer_common/sanitizer_platform_limits_posix.h>
 
 #include "xsan_attribute.h"
+#include "xsan_flags.h"
 #include "xsan_hooks_dispatch.h"
 #include "xsan_interface_internal.h"
+#include "xsan_profile.h"
 
 namespace __sanitizer {
 struct CommonFlags;
@@ -37,6 +39,8 @@ struct XsanInterceptorContext {
   const char *interceptor_name;
   /// TODO: should use pointer or reference?
   XsanContext &xsan_ctx;
+  /// The caller of the interceptor if the call is sampled by the profiler.
+  uptr profile_pc = 0;
 };
 
 // ---------------------- Hook for other Sanitizers -------------------
@@ -52,29 +56,62 @@ ALWAYS_INLINE void NeededMapRanges(Container &res) {
   XSAN_HOOKS_EXEC_EXTEND(res, NeededMapRanges);
 }
 
-extern THREADLOCAL int is_in_symbolizer;
-ALWAYS_INLINE bool in_symbolizer() { return UNLIKELY(is_in_symbolizer > 0); }
+template <typename Container>
+ALWAYS_INLINE void HotShadowRanges(Container &res) {
+  XSAN_HOOKS_EXEC_EXTEND(res, HotShadowRanges);
+}
+
+/// The per-thread state of XSan making the interceptors fall back to the real
+/// functions, packed into one word kept in sync by every ignore scope. Hence
+/// the interceptors check it by a single TLS load and compare (see
+/// ShouldXsanIgnoreInterceptor), instead of reading a TLS slot per counter.
+union XsanThreadState {
+  struct {
+    u16 ignore_interceptors;  // ScopedIgnoreInterceptors
+    u16 in_internal;          // ScopedXsanInternal
+    u8 in_symbolizer;         // EnterSymbolizer/ExitSymbolizer
+    u8 in_unwind;             // OnEnterUnwind/OnExitUnwind
+    // Whether XSan and the XsanThread of the current thread are initialized.
+    u8 running;
+    u8 unused;
+  };
+  u64 raw;
+
+  // Running with no ignore scope entered.
+  static constexpr u64 kRunning = 1ULL << 48;
+};
+static_assert(sizeof(XsanThreadState) == sizeof(u64),
+              "XsanThreadState must be loaded at once");
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "XsanThreadState::kRunning assumes a little endian layout");
+
+extern THREADLOCAL XsanThreadState xsan_thread_state;
+
+ALWAYS_INLINE bool in_symbolizer() {
+  return UNLIKELY(xsan_thread_state.in_symbolizer > 0);
+}
 
 ALWAYS_INLINE void EnterSymbolizer() {
-  ++is_in_symbolizer;
+  ++xsan_thread_state.in_symbolizer;
   XSAN_HOOKS_EXEC(EnterSymbolizer);
 }
 
 ALWAYS_INLINE void ExitSymbolizer() {
-  --is_in_symbolizer;
+  --xsan_thread_state.in_symbolizer;
   XSAN_HOOKS_EXEC(ExitSymbolizer);
 }
 
-extern THREADLOCAL int xsan_in_unwind;
 ALWAYS_INLINE void OnEnterUnwind() {
-  ++xsan_in_unwind;
+  ++xsan_thread_state.in_unwind;
   XSAN_HOOKS_EXEC(OnEnterUnwind);
 }
 ALWAYS_INLINE void OnExitUnwind() {
-  --xsan_in_unwind;
+  --xsan_thread_state.in_unwind;
   XSAN_HOOKS_EXEC(OnExitUnwind);
 }
-ALWAYS_INLINE bool IsInUnwind() { return UNLIKELY(xsan_in_unwind > 0); }
+ALWAYS_INLINE bool IsInUnwind() {
+  return UNLIKELY(xsan_thread_state.in_unwind > 0);
+}
 
 // If in symbolizer or unwinding, we are reporting errors, should not do
 // sanity checks and ignore interceptors.
@@ -86,19 +123,28 @@ ALWAYS_INLINE bool IsInSymbolizerOrUnwind() {
 /// Xsan function, e.g., __asan_handle_no_return.
 /// In such cases, Xsan should not do sanity checks.
 /// Compared to ShouldIgnoreInterceptos(), this function ignores in_ignore_lib.
-extern THREADLOCAL int xsan_in_internal;
 ALWAYS_INLINE bool IsInXsanInternal() {
-  return xsan_in_internal != 0 ||
+  return xsan_thread_state.in_internal != 0 ||
          /* If in symbolizer or unwind, we are also in Xsan internal */
          IsInSymbolizerOrUnwind();
 }
 class ScopedXsanInternal {
  public:
-  ALWAYS_INLINE ScopedXsanInternal() { xsan_in_internal++; }
-  ALWAYS_INLINE ~ScopedXsanInternal() { xsan_in_internal--; }
+  ALWAYS_INLINE ScopedXsanInternal() { xsan_thread_state.in_internal++; }
+  ALWAYS_INLINE ~ScopedXsanInternal() { xsan_thread_state.in_internal--; }
 };
 
-ALWAYS_INLINE bool ShouldSanitzerIgnoreInterceptors(
+/// Unlike ShouldSanitzerIgnoreInterceptors, XSan's own state is not checked.
+XSAN_FLATTEN ALWAYS_INLINE bool ShouldSubSanitizersIgnoreInterceptors(
+    const XsanContext &xsan_thr) {
+  bool should_ignore = false;
+  /// TODO: to support libignore, we plan to migrate it to Xsan.
+  /// xsan_suppressions.cpp is required accordingly.
+  XSAN_HOOKS_EXEC_OR(should_ignore, ShouldIgnoreInterceptors, xsan_thr);
+  return should_ignore;
+}
+
+XSAN_FLATTEN ALWAYS_INLINE bool ShouldSanitzerIgnoreInterceptors(
     const XsanContext &xsan_thr) {
   /// Avoid sanity checks in XSan internal or SymbolizerOrUnwind
   if (IsInXsanInternal())
@@ -110,7 +156,7 @@ ALWAYS_INLINE bool ShouldSanitzerIgnoreInterceptors(
   return should_ignore;
 }
 
-ALWAYS_INLINE bool ShouldSanitzerIgnoreAllocFreeHook() {
+XSAN_FLATTEN ALWAYS_INLINE bool ShouldSanitzerIgnoreAllocFreeHook() {
   bool should_ignore = false;
   XSAN_HOOKS_EXEC_OR(should_ignore, ShouldIgnoreAllocFreeHook);
   return should_ignore;
@@ -132,20 +178,38 @@ ALWAYS_INLINE void OnAllocatorUnmap(uptr p, uptr size) {
   XSAN_HOOKS_EXEC(OnAllocatorUnmap, p, size);
 }
 
-ALWAYS_INLINE void XsanAllocHook(uptr ptr, uptr size,
-                                 BufferedStackTrace *stack) {
-  XSAN_HOOKS_EXEC(OnXsanAllocHook, ptr, size, stack);
+/// The stack is put into the stack depot once per alloc/free by the allocator,
+/// and its ID is shared by all sub-sanitizers. A stack_id of 0 means that the
+/// stack is not in the depot, and a sub-sanitizer needing it puts it itself.
+ALWAYS_INLINE void XsanAllocHook(uptr ptr, uptr size, BufferedStackTrace *stack,
+                                 u32 stack_id) {
+  XSAN_HOOKS_EXEC(OnXsanAllocHook, ptr, size, stack, stack_id);
 }
 
-ALWAYS_INLINE void XsanFreeHook(uptr ptr, uptr size,
-                                BufferedStackTrace *stack) {
-  XSAN_HOOKS_EXEC(OnXsanFreeHook, ptr, size, stack);
+ALWAYS_INLINE void XsanFreeHook(uptr ptr, uptr size, BufferedStackTrace *stack,
+                                u32 stack_id) {
+  XSAN_HOOKS_EXEC(OnXsanFreeHook, ptr, size, stack, stack_id);
 }
 
 ALWAYS_INLINE void XsanAllocFreeTailHook(uptr pc) {
   XSAN_HOOKS_EXEC(OnXsanAllocFreeTailHook, pc);
 }
 
+/// Whether the free hooks of primary chunks are delivered on recycling from
+/// ASan's quarantine (XsanRecycleHook) instead of on free (XsanFreeHook).
+/// Only depends on flags, hence it gives the same answer on free and recycle.
+ALWAYS_INLINE bool ShouldBatchXsanFreeHook() {
+  if (!flags()->batch_alloc_free_hooks)
+    return false;
+  bool require = false;
+  XSAN_HOOKS_EXEC_OR(require, RequirePerObjectFreeHook);
+  return !require;
+}
+
+ALWAYS_INLINE void XsanRecycleHook(uptr ptr, uptr size) {
+  XSAN_HOOKS_EXEC(OnXsanRecycleHook, ptr, size);
+}
+
 ALWAYS_INLINE void OnFakeStackAlloc(uptr addr, uptr size) {
   XSAN_HOOKS_EXEC(OnFakeStackAlloc, addr, size);
 }
@@ -304,6 +368,15 @@ ALWAYS_INLINE bool RequireStackTraces() {
   return require;
 }
 
+/// Whether copying [src, src + size) needs the stack trace. Unlike
+/// RequireStackTraces<copy>(), a sub-sanitizer may look at the source first,
+/// e.g., MSan only chains the origins of the poisoned bytes.
+ALWAYS_INLINE bool RequireStackTracesForCopy(const void *src, uptr size) {
+  bool require = false;
+  XSAN_HOOKS_EXEC_OR(require, RequireStackTracesForCopy, src, size);
+  return require;
+}
+
 template <XsanStackTraceType type>
 ALWAYS_INLINE int RequireStackTracesSize() {
   int size = -1;
@@ -323,15 +396,50 @@ struct XsanFuncScope {
 ALWAYS_INLINE void InitializeInterceptors() {
   XSAN_HOOKS_EXEC(InitializeInterceptors);
 }
+// The range checks of a sampled interceptor call are attributed to its caller.
+#define XSAN_HOOKS_EXEC_RANGE(ctx, size, FUNC, ...)                         \
+  do {                                                                      \
+    if (UNLIKELY(ctx && ctx->profile_pc))                                   \
+      XSAN_HOOKS_EXEC_SAMPLED(ctx->profile_pc, ProfileKind::Interceptor,    \
+                              ctx->interceptor_name, size, FUNC,            \
+                              __VA_ARGS__);                                 \
+    else                                                                    \
+      XSAN_HOOKS_EXEC(FUNC, __VA_ARGS__);                                   \
+  } while (0)
+
 PSEUDO_MACRO void ReadRange(void *_ctx, const void *offset, uptr size) {
   XsanInterceptorContext *ctx = (XsanInterceptorContext *)_ctx;
-  XSAN_HOOKS_EXEC(ReadRange, XsanContext::Ptr{ctx ? &ctx->xsan_ctx : nullptr},
-                  offset, size, (ctx ? ctx->interceptor_name : nullptr));
+  XSAN_HOOKS_EXEC_RANGE(ctx, size, ReadRange,
+                        XsanContext::Ptr{ctx ? &ctx->xsan_ctx : nullptr},
+                        offset, size, (ctx ? ctx->interceptor_name : nullptr));
+}
+// Whether some sub-sanitizer needs to check the piece [beg, end) of a string
+// precisely, see ScanString.
+ALWAYS_INLINE bool StringPieceNeedsCheck(uptr beg, uptr end) {
+  bool need_check = false;
+  XSAN_HOOKS_EXEC_OR(need_check, StringPieceNeedsCheck, beg, end);
+  return need_check;
+}
+// Whether some sub-sanitizer may report the accesses to [beg, beg + size).
+ALWAYS_INLINE bool MayReportRange(uptr beg, uptr size) {
+  bool may_report = false;
+  XSAN_HOOKS_EXEC_OR(may_report, MayReportRange, beg, size);
+  return may_report;
+}
+// ReadRange of a string whose pieces have been passed to StringPieceNeedsCheck.
+PSEUDO_MACRO void ReadScannedString(void *_ctx, const void *offset, uptr size,
+                                    bool need_check) {
+  XsanInterceptorContext *ctx = (XsanInterceptorContext *)_ctx;
+  XSAN_HOOKS_EXEC_RANGE(ctx, size, ReadScannedString,
+                        XsanContext::Ptr{ctx ? &ctx->xsan_ctx : nullptr},
+                        offset, size, need_check,
+                        (ctx ? ctx->interceptor_name : nullptr));
 }
 PSEUDO_MACRO void WriteRange(void *_ctx, const void *offset, uptr size) {
   XsanInterceptorContext *ctx = (XsanInterceptorContext *)_ctx;
-  XSAN_HOOKS_EXEC(WriteRange, XsanContext::Ptr{ctx ? &ctx->xsan_ctx : nullptr},
-                  offset, size, (ctx ? ctx->interceptor_name : nullptr));
+  XSAN_HOOKS_EXEC_RANGE(ctx, size, WriteRange,
+                        XsanContext::Ptr{ctx ? &ctx->xsan_ctx : nullptr},
+                        offset, size, (ctx ? ctx->interceptor_name : nullptr));
 }
 // "use" means that the value is:
 // 1. dereferenced as a pointer
@@ -380,15 +488,15 @@ PSEUDO_MACRO void InitRange(void *_ctx, const void *offset, uptr size) {
 }
 PSEUDO_MACRO void CommonReadRange(void *_ctx, const void *offset, uptr size) {
   XsanInterceptorContext *ctx = (XsanInterceptorContext *)_ctx;
-  XSAN_HOOKS_EXEC(CommonReadRange,
-                  XsanContext::Ptr{ctx ? &ctx->xsan_ctx : nullptr}, offset,
-                  size, (ctx ? ctx->interceptor_name : nullptr));
+  XSAN_HOOKS_EXEC_RANGE(ctx, size, CommonReadRange,
+                        XsanContext::Ptr{ctx ? &ctx->xsan_ctx : nullptr},
+                        offset, size, (ctx ? ctx->interceptor_name : nullptr));
 }
 PSEUDO_MACRO void CommonWriteRange(void *_ctx, const void *offset, uptr size) {
   XsanInterceptorContext *ctx = (XsanInterceptorContext *)_ctx;
-  XSAN_HOOKS_EXEC(CommonWriteRange,
-                  XsanContext::Ptr{ctx ? &ctx->xsan_ctx : nullptr}, offset,
-                  size, (ctx ? ctx->interceptor_name : nullptr));
+  XSAN_HOOKS_EXEC_RANGE(ctx, size, CommonWriteRange,
+                        XsanContext::Ptr{ctx ? &ctx->xsan_ctx : nullptr},
+                        offset, size, (ctx ? ctx->interceptor_name : nullptr));
 }
 PSEUDO_MACRO void CommonUnpoisonParam(uptr count) {
   XSAN_HOOKS_EXEC(CommonUnpoisonParam, count);
@@ -420,4 +528,19 @@ PSEUDO_MACRO void CommonSyscallPostWriteRange(const XsanInterceptorContext &ctx,
                   ctx.interceptor_name);
 }
 
+/// Fused check of one aligned memory access: all shadows are prefetched from
+/// the single app address first, then ASan's inline fast path runs before the
+/// remaining sub-sanitizers. __xsan_readN/__xsan_writeN are the outlined
+/// versions of these.
+template <u32 size>
+PSEUDO_MACRO void XsanRead(uptr p) {
+  XSAN_HOOKS_EXEC(PrefetchShadow, p);
+  XSAN_HOOKS_EXEC(__xsan_read<size>, p);
+}
+template <u32 size>
+PSEUDO_MACRO void XsanWrite(uptr p) {
+  XSAN_HOOKS_EXEC(PrefetchShadow, p);
+  XSAN_HOOKS_EXEC(__xsan_write<size>, p);
+}
+
 }  // namespace __xsan
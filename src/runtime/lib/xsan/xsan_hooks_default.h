@@ -50,6 +50,11 @@ struct DefaultHooks {
   ALWAYS_INLINE static __sanitizer::ArrayRef<NamedRange> NeededMapRanges() {
     return {};
   }
+  // Return the shadow of the heap, which is touched by every allocation.
+  // They are a subset of NeededMapRanges.
+  ALWAYS_INLINE static __sanitizer::ArrayRef<NamedRange> HotShadowRanges() {
+    return {};
+  }
   // ---------- End of Xsan-Initialization-Related Hooks ----------------
 
   // ----------- State/Ignoration Management Hooks -----------
@@ -85,10 +90,19 @@ struct DefaultHooks {
                                                     uptr user_size) {}
   ALWAYS_INLINE static void OnAllocatorUnmap(uptr p, uptr size) {}
   ALWAYS_INLINE static void OnXsanAllocHook(uptr ptr, uptr size,
-                                            BufferedStackTrace *stack) {}
+                                            BufferedStackTrace *stack,
+                                            u32 stack_id) {}
   ALWAYS_INLINE static void OnXsanFreeHook(uptr ptr, uptr size,
-                                           BufferedStackTrace *stack) {}
+                                           BufferedStackTrace *stack,
+                                           u32 stack_id) {}
   ALWAYS_INLINE static void OnXsanAllocFreeTailHook(uptr pc) {}
+  // With the batch_alloc_free_hooks flag, OnXsanFreeHook is not called for
+  // primary chunks, OnXsanRecycleHook is called once ASan recycles them from
+  // the quarantine instead, still once per chunk. A sanitizer that needs the
+  // free-time context (e.g., the stack for MSan origins, or the freeing
+  // thread for TSan) vetoes it by returning true.
+  ALWAYS_INLINE static bool RequirePerObjectFreeHook() { return false; }
+  ALWAYS_INLINE static void OnXsanRecycleHook(uptr ptr, uptr size) {}
   // ASan replaces allocs with fake stack frames, so we need to track them.
   // E.g., MSan needs to poison the fake stack frames.
   ALWAYS_INLINE static void OnFakeStackAlloc(uptr addr, uptr size) {}
@@ -185,6 +199,10 @@ struct DefaultHooks {
 
   // ---------- Require Stack Trace Hooks ----------------
   ALWAYS_INLINE static bool RequireStackTraces() { return false; }
+  ALWAYS_INLINE static bool RequireStackTracesForCopy(const void *src,
+                                                      uptr size) {
+    return false;
+  }
   ALWAYS_INLINE static int RequireStackTracesSize() { return -1; }
   // ---------- End of Require Stack Trace Hooks ----------------
 
@@ -250,6 +268,24 @@ struct DefaultHooks {
   ALWAYS_INLINE static void InitializeInterceptors() {}
   PSEUDO_MACRO static void ReadRange(const Context *ctx, const void *offset,
                                      uptr size, const char *func_name) {}
+  // The string interceptors look for the terminator and pass each piece
+  // [beg, end) of the string, at most one vector long, to
+  // StringPieceNeedsCheck in the same loop (see ScanString). Then
+  // ReadScannedString replaces ReadRange, where `need_check` tells whether any
+  // piece needs the precise check. The sanitizers overriding ReadRange should
+  // override ReadScannedString as well.
+  ALWAYS_INLINE static bool StringPieceNeedsCheck(uptr beg, uptr end) {
+    return false;
+  }
+  // Whether the accesses to [beg, beg + size) may be reported, which keeps a
+  // versioned loop from running its clone without the checks.
+  ALWAYS_INLINE static bool MayReportRange(uptr beg, uptr size) {
+    return false;
+  }
+  PSEUDO_MACRO static void ReadScannedString(const Context *ctx,
+                                             const void *offset, uptr size,
+                                             bool need_check,
+                                             const char *func_name) {}
   PSEUDO_MACRO static void WriteRange(const Context *ctx, const void *offset,
                                       uptr size, const char *func_name) {}
   // "use" means that the value is:
@@ -312,10 +348,23 @@ struct DefaultHooks {
   ALWAYS_INLINE static void __xsan_unaligned_read(uptr p) {}
   template <u32 WriteSize>
   ALWAYS_INLINE static void __xsan_unaligned_write(uptr p) {}
+  /// Issued by the fused access check before any __xsan_read/__xsan_write, so
+  /// that the shadow touched by a later sub-sanitizer is already in flight
+  /// while the earlier ones check theirs.
+  ALWAYS_INLINE static void PrefetchShadow(uptr p) {}
   template <u32 ReadSize>
   ALWAYS_INLINE static void __xsan_read(uptr p) {}
   template <u32 WriteSize>
   ALWAYS_INLINE static void __xsan_write(uptr p) {}
+  /// Periodic accesses {beg + k * step | beg + k * step < end} combined from
+  /// a loop, where beg < end and step > access size.
+  /// Sub-sanitizers are expected to check them in bulk rather than element by
+  /// element.
+  template <u32 ReadSize>
+  ALWAYS_INLINE static void __xsan_period_read(uptr beg, uptr end, uptr step) {}
+  template <u32 WriteSize>
+  ALWAYS_INLINE static void __xsan_period_write(uptr beg, uptr end,
+                                                uptr step) {}
   // ---------- End of Xsan-Interface-Related Hooks ----------------
 };
 
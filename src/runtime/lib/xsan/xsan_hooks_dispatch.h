@@ -1,26 +1,48 @@
 #pragma once
 
+#include <sanitizer_common/sanitizer_internal_defs.h>
+
 #include "xsan_hooks_gen.h"
 
-static inline void ReduceOr(bool& res, bool a) { res = res || a; }
+namespace __xsan {
+
+/// XSAN_HOOKS_EXEC_REDUCE passes each reducer one thunk per delegated
+/// sanitizer (in the order of XSAN_DELEGATED_SANITIZERS). The reducers fold
+/// over the pack, so a hook is not called at all once the result is decided,
+/// e.g., TSan's ShouldIgnoreInterceptors is skipped if ASan already said yes.
+/// The thunks are always_inline, hence the no-op hooks inherited from
+/// DefaultHooks fold to constants and vanish from the caller.
 
-template <typename T>
-static inline void ReduceMax(T& res, T a) {
-  if (res < a)
-    res = a;
+template <typename... Thunks>
+ALWAYS_INLINE void ReduceOr(bool &res, Thunks &&...thunks) {
+  res = (res || ... || thunks());
 }
 
-template <auto val, typename T>
-static inline void ReduceNeq(T& res, T a) {
-  if (res == val)
-    res = a;
+template <typename T, typename... Thunks>
+ALWAYS_INLINE void ReduceMax(T &res, Thunks &&...thunks) {
+  auto max = [&res](const T &a) {
+    if (res < a)
+      res = a;
+  };
+  (max(thunks()), ...);
 }
 
-template <typename Arr1, typename Arr2>
-static inline void ReduceExtend(Arr1& res, const Arr2& a) {
-  for (auto& i : a) res.push_back(i);
+/// Keeps the first result that is not `val`.
+template <auto val, typename T, typename... Thunks>
+ALWAYS_INLINE void ReduceNeq(T &res, Thunks &&...thunks) {
+  (void)((res != val || ((res = thunks()), false)) || ...);
 }
 
+template <typename Arr, typename... Thunks>
+ALWAYS_INLINE void ReduceExtend(Arr &res, Thunks &&...thunks) {
+  auto extend = [&res](const auto &a) {
+    for (auto &i : a) res.push_back(i);
+  };
+  (extend(thunks()), ...);
+}
+
+}  // namespace __xsan
+
 #define XSAN_HOOKS_EXEC_OR(RES, FUNC, ...) \
   XSAN_HOOKS_EXEC_REDUCE(RES, ReduceOr, FUNC, __VA_ARGS__)
 
@@ -30,8 +30,10 @@ set(SANITIZER_MACRO_TEMPLATE [=[
 #  include "$SUBSAN_HOOK_HEADER_FILE_PATH$"
 #  define XSAN_HOOKS_EXEC_$SUBSAN_MACRO_NAME$(FUNC, ...) \\
     XSAN_HOOKS_TYPE($SUBSAN_ENUM_NAME$)::FUNC(__VA_ARGS__)
-#  define XSAN_HOOKS_EXEC_REDUCE_$SUBSAN_MACRO_NAME$(RES, RED, FUNC, ...) \\
-    RED(RES, XSAN_HOOKS_EXEC_$SUBSAN_MACRO_NAME$(FUNC, __VA_ARGS__))
+#  define XSAN_HOOKS_THUNK_$SUBSAN_MACRO_NAME$(FUNC, ...)                      \\
+    , [&]() __attribute__((always_inline)) -> decltype(auto) {            \\
+      return XSAN_HOOKS_EXEC_$SUBSAN_MACRO_NAME$(FUNC, __VA_ARGS__);        \\
+    }
 #  define XSAN_HOOKS_DEFINE_VAR_$SUBSAN_MACRO_NAME$(VAR) XSAN_HOOKS_TYPE($SUBSAN_ENUM_NAME$)::VAR $SUBSAN_VAR_NAME$;
 #  define XSAN_HOOKS_DEFINE_VAR_CVT_$SUBSAN_MACRO_NAME$(VAR)                                \\
     __attribute__((always_inline)) operator const XSAN_HOOKS_TYPE(           \\
@@ -49,15 +51,19 @@ set(SANITIZER_MACRO_TEMPLATE [=[
 #  define XSAN_HOOKS_ASSIGN_VAR_$SUBSAN_MACRO_NAME$(FUNC, ...) \\
     $SUBSAN_VAR_NAME$ = XSAN_HOOKS_EXEC_$SUBSAN_MACRO_NAME$(FUNC, __VA_ARGS__);
 #  define XSAN_HOOKS_CHECK_IMPL_$SUBSAN_MACRO_NAME$ XSAN_HOOKS_CHECK_IMPL($SUBSAN_ENUM_NAME$)
+#  define XSAN_HOOKS_PROFILE_$SUBSAN_MACRO_NAME$(PROF, FUNC, ...) \\
+    PROF(::__xsan::XsanHooksSanitizer::$SUBSAN_ENUM_NAME$,       \\
+         XSAN_HOOKS_EXEC_$SUBSAN_MACRO_NAME$(FUNC, __VA_ARGS__))
 #else
 #  define XSAN_HOOKS_EXEC_$SUBSAN_MACRO_NAME$(FUNC, ...)
-#  define XSAN_HOOKS_EXEC_REDUCE_$SUBSAN_MACRO_NAME$(RES, RED, FUNC, ...)
+#  define XSAN_HOOKS_THUNK_$SUBSAN_MACRO_NAME$(FUNC, ...)
 #  define XSAN_HOOKS_DEFINE_VAR_$SUBSAN_MACRO_NAME$(VAR)
 #  define XSAN_HOOKS_DEFINE_VAR_CVT_$SUBSAN_MACRO_NAME$(VAR)
 #  define XSAN_HOOKS_DEFINE_PTR_VAR_$SUBSAN_MACRO_NAME$(NAME, VAR)
 #  define XSAN_HOOKS_INIT_VAR_$SUBSAN_MACRO_NAME$(...)
 #  define XSAN_HOOKS_ASSIGN_VAR_$SUBSAN_MACRO_NAME$(FUNC, ...)
 #  define XSAN_HOOKS_CHECK_IMPL_$SUBSAN_MACRO_NAME$
+#  define XSAN_HOOKS_PROFILE_$SUBSAN_MACRO_NAME$(PROF, FUNC, ...)
 #endif
 
 ]=]) 
@@ -101,18 +107,40 @@ ${XSAN_HOOKS_EXEC_INNER_CALLS}  } while (0)
 ]=])
 extend_string_if(TRUE "${XSAN_HOOKS_EXEC_MACRO_DEFINITION}" XSAN_HOOKS_CONTENT)
 
+# generate XSAN_HOOKS_EXEC_PROFILED macro
+# Same as XSAN_HOOKS_EXEC, but each sanitizer's call is wrapped by
+# PROF(XsanHooksSanitizer::SAN, CALL), so that its cost can be attributed.
+set(XSAN_HOOKS_EXEC_PROFILED_INNER_CALLS "")
+if(XSAN_DELEGATED_SANITIZERS)
+  foreach(SanitizerName ${XSAN_DELEGATED_SANITIZERS})
+    string(TOUPPER ${SanitizerName} SanitizerNameUpper)
+    set(XSAN_HOOKS_EXEC_PROFILED_INNER_CALLS "${XSAN_HOOKS_EXEC_PROFILED_INNER_CALLS}    XSAN_HOOKS_PROFILE_${SanitizerNameUpper}(PROF, FUNC, __VA_ARGS__); \\\n")
+  endforeach()
+endif()
+set(XSAN_HOOKS_EXEC_PROFILED_MACRO_DEFINITION [=[
+#define XSAN_HOOKS_EXEC_PROFILED(PROF, FUNC, ...) \\
+  do {                                           \\
+${XSAN_HOOKS_EXEC_PROFILED_INNER_CALLS}  } while (0)
+
+]=])
+extend_string_if(TRUE "${XSAN_HOOKS_EXEC_PROFILED_MACRO_DEFINITION}" XSAN_HOOKS_CONTENT)
+
 # generate XSAN_HOOKS_EXEC_REDUCE macro
-set(XSAN_HOOKS_EXEC_REDUCE_INNER_CALLS "")
+# The reducer receives one thunk per delegated sanitizer, so that it can fold
+# over them and skip the remaining hooks once the result is known.
+set(XSAN_HOOKS_EXEC_REDUCE_INNER_THUNKS "")
 if(XSAN_DELEGATED_SANITIZERS)
   foreach(SanitizerName ${XSAN_DELEGATED_SANITIZERS})
     string(TOUPPER ${SanitizerName} SanitizerNameUpper)
-    set(XSAN_HOOKS_EXEC_REDUCE_INNER_CALLS "${XSAN_HOOKS_EXEC_REDUCE_INNER_CALLS}    XSAN_HOOKS_EXEC_REDUCE_${SanitizerNameUpper}(RES, RED, FUNC, __VA_ARGS__); \\\n")
+    set(XSAN_HOOKS_EXEC_REDUCE_INNER_THUNKS "${XSAN_HOOKS_EXEC_REDUCE_INNER_THUNKS}      XSAN_HOOKS_THUNK_${SanitizerNameUpper}(FUNC, __VA_ARGS__) \\\n")
   endforeach()
 endif()
 set(XSAN_HOOKS_EXEC_REDUCE_MACRO_DEFINITION [=[
 #define XSAN_HOOKS_EXEC_REDUCE(RES, RED, FUNC, ...)           \\
   do {                                                        \\
-${XSAN_HOOKS_EXEC_REDUCE_INNER_CALLS}  } while (0)
+    ::__xsan::RED(RES                                         \\
+${XSAN_HOOKS_EXEC_REDUCE_INNER_THUNKS}    );                                                        \\
+  } while (0)
 
 ]=])
 extend_string_if(TRUE "${XSAN_HOOKS_EXEC_REDUCE_MACRO_DEFINITION}" XSAN_HOOKS_CONTENT)
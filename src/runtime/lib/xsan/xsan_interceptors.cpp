@@ -75,19 +75,17 @@ extern "C" int dirfd(void *dirp);
 
 namespace __xsan {
 
-THREADLOCAL uptr xsan_ignore_interceptors = 0;
-
 ScopedIgnoreInterceptors::ScopedIgnoreInterceptors(bool in_report)
 #  if XSAN_CONTAINS_TSAN
     : tsan_sii(),
       sit(in_report)
 #  endif
 {
-  xsan_ignore_interceptors++;
+  xsan_thread_state.ignore_interceptors++;
 }
 
 ScopedIgnoreInterceptors::~ScopedIgnoreInterceptors() {
-  xsan_ignore_interceptors--;
+  xsan_thread_state.ignore_interceptors--;
 }
 
 ScopedIgnoreChecks::ScopedIgnoreChecks() : ScopedIgnoreChecks(GET_CALLER_PC()) {}
@@ -428,7 +426,7 @@ static int munmap_interceptor(void *ctx, Munmap real_munmap, void *addr,
     __xsan::XsanInterceptorContext _ctx = {__func__, xsan_ctx}; \
     (void)_ctx;                                                 \
     __xsan::XsanThread *xsan_thr = __xsan::GetCurrentThread();  \
-    if (xsan_ignore_interceptors)                               \
+    if (xsan_thread_state.ignore_interceptors)                  \
       return;                                                   \
     ScopedSyscall scoped_syscall(xsan_thr)
 
@@ -943,11 +941,13 @@ INTERCEPTOR(char *, strcat, char *to, const char *from) {
   XSAN_INTERCEPTOR_ENTER(ctx, strcat, to, from);
   XsanInitFromRtl();
   if (__xsan::flags()->replace_str) {
-    uptr from_length = internal_strlen(from);
-    XSAN_READ_RANGE(ctx, from, from_length + 1);
+    bool from_need_check, to_need_check;
+    uptr from_length = XsanStrlen(from, from_need_check);
+    XSAN_READ_SCANNED_STRING(ctx, from, from_length + 1, from_need_check);
     XSAN_USE_STRING(ctx, from, from_length);
-    uptr to_length = internal_strlen(to);
-    XSAN_READ_STRING_OF_LEN(ctx, to, to_length, to_length);
+    uptr to_length = XsanStrlen(to, to_need_check);
+    XSAN_READ_SCANNED_STRING_OF_LEN(ctx, to, to_length, to_length,
+                                    to_need_check);
     XSAN_WRITE_RANGE(ctx, to + to_length, from_length + 1);
     XSAN_USE_STRING(ctx, to, to_length);
     XSAN_COPY_RANGE(ctx, to + to_length, from, from_length + 1);
@@ -970,8 +970,10 @@ INTERCEPTOR(char *, strncat, char *to, const char *from, usize size) {
     uptr from_length = MaybeRealStrnlen(from, size);
     uptr copy_length = Min<uptr>(size, from_length + 1);
     XSAN_READ_RANGE(ctx, from, copy_length);
-    uptr to_length = internal_strlen(to);
-    XSAN_READ_STRING_OF_LEN(ctx, to, to_length, to_length);
+    bool to_need_check;
+    uptr to_length = XsanStrlen(to, to_need_check);
+    XSAN_READ_SCANNED_STRING_OF_LEN(ctx, to, to_length, to_length,
+                                    to_need_check);
     XSAN_WRITE_RANGE(ctx, to + to_length, from_length + 1);
     XSAN_USE_STRING(ctx, to, to_length);
     XSAN_COPY_RANGE(ctx, to + to_length, from, copy_length);
@@ -998,9 +1000,10 @@ INTERCEPTOR(char *, strcpy, char *to, const char *from) {
   }
 
   if (__xsan::flags()->replace_str) {
-    uptr from_size = internal_strlen(from) + 1;
+    bool need_check;
+    uptr from_size = XsanStrlen(from, need_check) + 1;
     CHECK_RANGES_OVERLAP("strcpy", to, from_size, from, from_size);
-    XSAN_READ_RANGE(ctx, from, from_size);
+    XSAN_READ_SCANNED_STRING(ctx, from, from_size, need_check);
     XSAN_WRITE_RANGE(ctx, to, from_size);
     XSAN_USE_STRING(ctx, from, from_size - 1);
     XSAN_COPY_RANGE(ctx, to, from, from_size);
@@ -1025,9 +1028,10 @@ INTERCEPTOR(char *, strdup, const char *s) {
   FUNC_SCOPE(strdup);
   if (UNLIKELY(!TryXsanInitFromRtl()))
     return internal_strdup(s);
-  uptr length = internal_strlen(s);
+  bool need_check;
+  uptr length = XsanStrlen(s, need_check);
   if (__xsan::flags()->replace_str) {
-    XSAN_READ_RANGE(ctx, s, length + 1);
+    XSAN_READ_SCANNED_STRING(ctx, s, length + 1, need_check);
     XSAN_USE_STRING(ctx, s, length);
   }
   UNINITIALIZED BufferedStackTrace stack;
@@ -1046,9 +1050,10 @@ INTERCEPTOR(char *, __strdup, const char *s) {
   XSAN_INTERCEPTOR_ENTER(ctx, strdup, s);
   if (UNLIKELY(!TryXsanInitFromRtl()))
     return internal_strdup(s);
-  uptr length = internal_strlen(s);
+  bool need_check;
+  uptr length = XsanStrlen(s, need_check);
   if (__xsan::flags()->replace_str) {
-    XSAN_READ_RANGE(ctx, s, length + 1);
+    XSAN_READ_SCANNED_STRING(ctx, s, length + 1, need_check);
     XSAN_USE_STRING(ctx, s, length);
   }
   UNINITIALIZED BufferedStackTrace stack;
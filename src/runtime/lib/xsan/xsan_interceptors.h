@@ -245,13 +245,11 @@ class ScopedInterceptor {
 #endif
 };
 
-extern THREADLOCAL uptr xsan_ignore_interceptors;
 inline bool ShouldXsanIgnoreInterceptor(const XsanContext &xsan_ctx) {
-  if (xsan_ignore_interceptors || !XsanInited())
+  // Any ignore scope, or XSan or the current thread not being initialized.
+  if (UNLIKELY(xsan_thread_state.raw != XsanThreadState::kRunning))
     return true;
-  XsanThread *thread = __xsan::GetCurrentThread();
-  return UNLIKELY(!thread || !thread->is_inited_ || thread->in_ignored_lib_) ||
-         __xsan::ShouldSanitzerIgnoreInterceptors(xsan_ctx);
+  return __xsan::ShouldSubSanitizersIgnoreInterceptors(xsan_ctx);
 }
 
 }  // namespace __xsan
@@ -292,16 +290,18 @@ inline bool ShouldXsanIgnoreInterceptor(const XsanContext &xsan_ctx) {
     return REAL(func)(__VA_ARGS__);
 
 /// TODO: use a better approach to use SCOPED_TSAN_INTERCEPTOR
-#define XSAN_INTERCEPTOR_ENTER(ctx, func, ...)     \
-  SCOPED_XSAN_INTERCEPTOR(func, __VA_ARGS__);      \
-  XsanInterceptorContext _ctx = {#func, xsan_ctx}; \
-  ctx = (void *)&_ctx;                             \
+#define XSAN_INTERCEPTOR_ENTER(ctx, func, ...)                   \
+  SCOPED_XSAN_INTERCEPTOR(func, __VA_ARGS__);                    \
+  XsanInterceptorContext _ctx = {#func, xsan_ctx,                \
+                                 XSAN_PROFILE_INTERCEPTOR_PC()}; \
+  ctx = (void *)&_ctx;                                           \
   (void)ctx;
 
-#define XSAN_INTERCEPTOR_ENTER_NO_IGNORE(ctx, func, ...) \
-  SCOPED_XSAN_INTERCEPTOR_RAW(func, __VA_ARGS__);        \
-  XsanInterceptorContext _ctx = {#func, xsan_ctx};       \
-  ctx = (void *)&_ctx;                                   \
+#define XSAN_INTERCEPTOR_ENTER_NO_IGNORE(ctx, func, ...)         \
+  SCOPED_XSAN_INTERCEPTOR_RAW(func, __VA_ARGS__);                \
+  XsanInterceptorContext _ctx = {#func, xsan_ctx,                \
+                                 XSAN_PROFILE_INTERCEPTOR_PC()}; \
+  ctx = (void *)&_ctx;                                           \
   (void)ctx;
 
 #define FUNC_SCOPE(func)                                      \
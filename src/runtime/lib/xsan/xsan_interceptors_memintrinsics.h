@@ -4,6 +4,7 @@
 #include "interception/interception.h"
 #include "sanitizer_common/sanitizer_internal_defs.h"
 #include "xsan_hooks.h"
+#include "xsan_simd.h"
 #include "xsan_stack.h"
 
 /// TODO: Implement suppression & flags
@@ -53,7 +54,7 @@ static inline bool XsanRangesOverlap(const char *offset1, uptr length1,
   do {                                                              \
     if (LIKELY(::__xsan::IsAppMem(dst) && __xsan::IsAppMem(src))) { \
       UNINITIALIZED BufferedStackTrace stack;                       \
-      GetStackTraceCopy(stack);                                     \
+      GetStackTraceCopy(stack, src, size);                          \
       ::__xsan::CopyRange(ctx, dst, src, size, stack);              \
     }                                                               \
   } while (0)
@@ -62,7 +63,7 @@ static inline bool XsanRangesOverlap(const char *offset1, uptr length1,
   do {                                                              \
     if (LIKELY(::__xsan::IsAppMem(dst) && __xsan::IsAppMem(src))) { \
       UNINITIALIZED BufferedStackTrace stack;                       \
-      GetStackTraceCopy(stack);                                     \
+      GetStackTraceCopy(stack, src, size);                          \
       ::__xsan::MoveRange(ctx, dst, src, size, stack);              \
     }                                                               \
   } while (0)
@@ -101,8 +102,39 @@ static inline bool XsanRangesOverlap(const char *offset1, uptr length1,
   XSAN_READ_RANGE((ctx), (s),                   \
                   (common_flags()->strict_string_checks ? (len) + 1 : (n)))
 
-#define XSAN_READ_STRING(ctx, s, n) \
-  XSAN_READ_STRING_OF_LEN((ctx), (s), internal_strlen(s), (n))
+// Return the length of the string |s|, and set |need_check| if some
+// sub-sanitizer needs to check its bytes precisely, in a single pass.
+ALWAYS_INLINE uptr XsanStrlen(const char *s, bool &need_check) {
+  need_check = false;
+  if (UNLIKELY(!IsAppMem(s)))
+    return internal_strlen(s);
+  return ScanString(s, [&need_check](uptr beg, uptr end) {
+    if (!need_check)
+      need_check = StringPieceNeedsCheck(beg, end);
+  });
+}
+
+#define XSAN_READ_SCANNED_STRING(ctx, s, size, need_check)    \
+  do {                                                        \
+    if (LIKELY(::__xsan::IsAppMem(s)))                        \
+      ::__xsan::ReadScannedString(ctx, s, size, need_check); \
+  } while (0)
+
+#define XSAN_READ_SCANNED_STRING_OF_LEN(ctx, s, len, n, need_check)   \
+  XSAN_READ_SCANNED_STRING(                                           \
+      (ctx), (s), (common_flags()->strict_string_checks ? (len) + 1 : (n)), \
+      (need_check))
+
+#define XSAN_READ_STRING(ctx, s, n)                             \
+  do {                                                          \
+    if (common_flags()->strict_string_checks) {                 \
+      bool need_check;                                          \
+      uptr len = ::__xsan::XsanStrlen((s), need_check);         \
+      XSAN_READ_SCANNED_STRING((ctx), (s), len + 1, need_check); \
+    } else {                                                    \
+      XSAN_READ_RANGE((ctx), (s), (n));                         \
+    }                                                           \
+  } while (0)
 
 // Only the last byte (0x0) is used for conditional judgement.
 #define XSAN_USE_STRING(ctx, s, len)          \
@@ -57,6 +57,13 @@ void __xsan_read_range(const void *beg, const void *end, uptr pc = 0) {
   /// The caller of __xsan_read_range should ensure that beg <= end
   DCHECK(beg < end && "Invalid range");
   uptr size = (uptr)end - (uptr)beg;
+  if (UNLIKELY(ProfileSampled())) {
+    if (LIKELY(IsAppMem(beg)))
+      XSAN_HOOKS_EXEC_SAMPLED(XSAN_PROFILE_PC(pc), ProfileKind::RangeRead,
+                              nullptr, size, ReadRange, XsanContext::Ptr{},
+                              beg, size, nullptr);
+    return;
+  }
   // Printf("beg: %p, end: %p, size: %lx\n", beg, end, size);
   /// TODO: use a more specific function to perform the check.
   XSAN_READ_RANGE((void *)nullptr, beg, size);
@@ -69,10 +76,30 @@ void __xsan_write_range(const void *beg, const void *end, uptr pc = 0) {
   /// The caller of __xsan_write_range should ensure that beg <= end
   DCHECK(beg < end && "Invalid range");
   uptr size = (uptr)end - (uptr)beg;
+  if (UNLIKELY(ProfileSampled())) {
+    if (LIKELY(IsAppMem(beg)))
+      XSAN_HOOKS_EXEC_SAMPLED(XSAN_PROFILE_PC(pc), ProfileKind::RangeWrite,
+                              nullptr, size, WriteRange, XsanContext::Ptr{},
+                              beg, size, nullptr);
+    return;
+  }
   XSAN_WRITE_RANGE((void *)nullptr, beg, size);
 }
 
-/// TODO: use SIMD to perform the check.
+/// Whether no sub-sanitizer would report the accesses to [beg, end), which
+/// lets a versioned loop run its clone without the checks.
+SANITIZER_INTERFACE_ATTRIBUTE
+int __xsan_range_is_clean(const void *beg, const void *end) {
+  if (UNLIKELY(beg >= end))
+    return beg == end;
+  // Leave the ranges out of the application memory to the checks.
+  if (UNLIKELY(!IsAppMem(beg) || !IsAppMem((const char *)end - 1)))
+    return 0;
+  return !MayReportRange((uptr)beg, (uptr)end - (uptr)beg);
+}
+
+/// The element-wise checks are delegated to the sub-sanitizers, which scan
+/// their shadow for the whole period in bulk.
 #define XSAN_PERIODICAL_OPERATION_CALLBACK_IMPL(operation, size_param)         \
   SANITIZER_INTERFACE_ATTRIBUTE                                                \
   void __xsan_period_##operation##size_param(const void *beg, const void *end, \
@@ -94,11 +121,19 @@ void __xsan_write_range(const void *beg, const void *end, uptr pc = 0) {
       return;                                                                  \
     }                                                                          \
     DCHECK(L <= R && "Invalid arguments");                                     \
-    for (uptr offset = L; offset < R; offset += step) {                        \
-      XSAN_HOOKS_EXEC(__xsan_##operation<size_param>, offset);                 \
+    if (UNLIKELY(ProfileSampled())) {                                          \
+      uptr bytes = (R - L + step - 1) / step * (size_param);                   \
+      XSAN_HOOKS_EXEC_SAMPLED(                                                 \
+          XSAN_PROFILE_PC(pc), XSAN_PERIOD_KIND_##operation, nullptr, bytes,   \
+          __xsan_period_##operation<size_param>, L, R, (uptr)step);            \
+      return;                                                                  \
     }                                                                          \
+    XSAN_HOOKS_EXEC(__xsan_period_##operation<size_param>, L, R, (uptr)step);  \
   }
 
+#define XSAN_PERIOD_KIND_read ProfileKind::PeriodRead
+#define XSAN_PERIOD_KIND_write ProfileKind::PeriodWrite
+
 #define XSAN_PERIODICAL_READ_CALLBACK(size) \
   XSAN_PERIODICAL_OPERATION_CALLBACK_IMPL(read, size)
 
@@ -116,17 +151,26 @@ XSAN_PERIODICAL_WRITE_CALLBACK(4)
 XSAN_PERIODICAL_WRITE_CALLBACK(8)
 XSAN_PERIODICAL_WRITE_CALLBACK(16)
 
-/// TODO: use a macro to perform the ASan check for better performance?
-#define XSAN_READ(size)                                \
-  SANITIZER_INTERFACE_ATTRIBUTE                        \
-  void __xsan_read##size(const void *p, uptr pc = 0) { \
-    XSAN_HOOKS_EXEC(__xsan_read<size>, (uptr)p);       \
+#define XSAN_READ(size)                                                   \
+  SANITIZER_INTERFACE_ATTRIBUTE                                           \
+  void __xsan_read##size(const void *p, uptr pc = 0) {                    \
+    if (UNLIKELY(ProfileSampled())) {                                     \
+      XSAN_HOOKS_EXEC_SAMPLED(XSAN_PROFILE_PC(pc), ProfileKind::Read,     \
+                              nullptr, size, __xsan_read<size>, (uptr)p); \
+      return;                                                             \
+    }                                                                     \
+    XsanRead<size>((uptr)p);                                              \
   }
 
-#define XSAN_WRITE(size)                                \
-  SANITIZER_INTERFACE_ATTRIBUTE                         \
-  void __xsan_write##size(const void *p, uptr pc = 0) { \
-    XSAN_HOOKS_EXEC(__xsan_write<size>, (uptr)p);       \
+#define XSAN_WRITE(size)                                                   \
+  SANITIZER_INTERFACE_ATTRIBUTE                                            \
+  void __xsan_write##size(const void *p, uptr pc = 0) {                    \
+    if (UNLIKELY(ProfileSampled())) {                                      \
+      XSAN_HOOKS_EXEC_SAMPLED(XSAN_PROFILE_PC(pc), ProfileKind::Write,     \
+                              nullptr, size, __xsan_write<size>, (uptr)p); \
+      return;                                                              \
+    }                                                                      \
+    XsanWrite<size>((uptr)p);                                              \
   }
 
 XSAN_READ(1)
@@ -134,9 +178,13 @@ XSAN_READ(2)
 XSAN_READ(4)
 XSAN_READ(8)
 XSAN_READ(16)
+XSAN_READ(32)
+XSAN_READ(64)
 XSAN_WRITE(1)
 XSAN_WRITE(2)
 XSAN_WRITE(4)
 XSAN_WRITE(8)
 XSAN_WRITE(16)
+XSAN_WRITE(32)
+XSAN_WRITE(64)
 }
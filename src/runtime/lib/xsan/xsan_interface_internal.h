@@ -22,6 +22,9 @@ SANITIZER_INTERFACE_ATTRIBUTE void __xsan_asan_init();
 SANITIZER_INTERFACE_ATTRIBUTE
 const char *__xsan_default_options();
 
+// Prints the resident memory of each region of XSan's memory map.
+SANITIZER_INTERFACE_ATTRIBUTE void __xsan_print_shadow_rss();
+
 // This macro set visibility to default (i.e., not hidden), which export the
 // external symbol to other module.
 SANITIZER_INTERFACE_ATTRIBUTE
@@ -79,6 +79,10 @@ void NORETURN ShowStatsAndAbort();
 // xsan_shadow_setup.cpp
 void InitializeShadowMemory();
 
+// xsan_shadow.cpp
+void InitializeShadowMemoryPolicy();
+void PrintShadowMemoryRss();
+
 // xsan_malloc_linux.cpp / xsan_malloc_mac.cpp
 void ReplaceSystemMalloc();
 
@@ -476,6 +476,19 @@ void InitializePlatformEarly() {
     Printf("FATAL: Found %zd - Supported 39, 42 and 48\n", vmaSize);
     Die();
   }
+  // MSan's mapping is compiled into the instrumented code.
+  if (XSAN_CONTAINS_MSAN && vmaSize != 48) {
+    Printf("FATAL: Xsan: MemorySanitizer only supports the 48-bit VMA\n");
+    Printf("FATAL: Found %zd - Supported 48\n", vmaSize);
+    Die();
+  }
+  if (vmaSize < XSAN_AARCH64_MIN_VMA) {
+    Printf("FATAL: Xsan: unsupported VMA range\n");
+    Printf("FATAL: Found %zd - Supported %d and above, rebuild XSan with "
+           "-DXSAN_AARCH64_MIN_VMA=%zd\n",
+           vmaSize, XSAN_AARCH64_MIN_VMA, vmaSize);
+    Die();
+  }
 #    else
   if (vmaSize != 48) {
     Printf("FATAL: Xsan: unsupported VMA range\n");
@@ -8,6 +8,13 @@
 
 #include "xsan_platform_mapping.h"
 
+// The smallest aarch64 VMA size (39, 42 or 48) the runtime supports, see
+// xsan_config.cmake. It decides the placement of ASan's heap, and whether the
+// mappings are selected by the VMA size at all.
+#ifndef XSAN_AARCH64_MIN_VMA
+#  define XSAN_AARCH64_MIN_VMA 48
+#endif
+
 namespace __xsan {
 
 enum {
@@ -160,71 +167,6 @@ struct MappingAppleAarch64 {
   static constexpr const uptr kMidAppMemEnd = 0;
 };
 
-/*
-C/C++ on linux/aarch64 (39-bit VMA)
-0000 0010 00 - 0100 0000 00: main binary
-0100 0000 00 - 0400 0000 00: -
-0400 0000 00 - 1000 0000 00: shadow memory
-2000 0000 00 - 3100 0000 00: -
-3100 0000 00 - 3400 0000 00: metainfo
-3400 0000 00 - 5500 0000 00: -
-5500 0000 00 - 5600 0000 00: main binary (PIE)
-5600 0000 00 - 7c00 0000 00: -
-7c00 0000 00 - 7d00 0000 00: heap
-7d00 0000 00 - 7fff ffff ff: modules and main thread stack
-*/
-struct MappingAarch64_39 {
-  static constexpr const uptr kLoAppMemBeg = 0x0000001000ull;
-  static constexpr const uptr kLoAppMemEnd = 0x0100000000ull;
-  static constexpr const uptr kTsanShadowBeg = 0x0400000000ull;
-  static constexpr const uptr kTsanShadowEnd = 0x1000000000ull;
-  static constexpr const uptr kTsanMetaShadowBeg = 0x3100000000ull;
-  static constexpr const uptr kTsanMetaShadowEnd = 0x3400000000ull;
-  static constexpr const uptr kMidAppMemBeg = 0x5500000000ull;
-  static constexpr const uptr kMidAppMemEnd = 0x5600000000ull;
-  static constexpr const uptr kHeapMemBeg = 0x7c00000000ull;
-  static constexpr const uptr kHeapMemEnd = 0x7d00000000ull;
-  static constexpr const uptr kHiAppMemBeg = 0x7e00000000ull;
-  static constexpr const uptr kHiAppMemEnd = 0x7fffffffffull;
-  static constexpr const uptr kTsanShadowMsk = 0x7800000000ull;
-  static constexpr const uptr kTsanShadowXor = 0x0200000000ull;
-  static constexpr const uptr kTsanShadowAdd = 0x0000000000ull;
-  static constexpr const uptr kVdsoBeg = 0x7f00000000ull;
-};
-
-/*
-C/C++ on linux/aarch64 (42-bit VMA)
-00000 0010 00 - 01000 0000 00: main binary
-01000 0000 00 - 08000 0000 00: -
-08000 0000 00 - 10000 0000 00: shadow memory
-10000 0000 00 - 26000 0000 00: -
-26000 0000 00 - 28000 0000 00: metainfo
-28000 0000 00 - 2aa00 0000 00: -
-2aa00 0000 00 - 2ab00 0000 00: main binary (PIE)
-2ab00 0000 00 - 3e000 0000 00: -
-3e000 0000 00 - 3f000 0000 00: heap
-3f000 0000 00 - 3ffff ffff ff: modules and main thread stack
-*/
-struct MappingAarch64_42 {
-  static constexpr const uptr kBroken = kBrokenReverseMapping;
-  static constexpr const uptr kLoAppMemBeg = 0x00000001000ull;
-  static constexpr const uptr kLoAppMemEnd = 0x01000000000ull;
-  static constexpr const uptr kTsanShadowBeg = 0x08000000000ull;
-  static constexpr const uptr kTsanShadowEnd = 0x10000000000ull;
-  static constexpr const uptr kTsanMetaShadowBeg = 0x26000000000ull;
-  static constexpr const uptr kTsanMetaShadowEnd = 0x28000000000ull;
-  static constexpr const uptr kMidAppMemBeg = 0x2aa00000000ull;
-  static constexpr const uptr kMidAppMemEnd = 0x2ab00000000ull;
-  static constexpr const uptr kHeapMemBeg = 0x3e000000000ull;
-  static constexpr const uptr kHeapMemEnd = 0x3f000000000ull;
-  static constexpr const uptr kHiAppMemBeg = 0x3f000000000ull;
-  static constexpr const uptr kHiAppMemEnd = 0x3ffffffffffull;
-  static constexpr const uptr kTsanShadowMsk = 0x3c000000000ull;
-  static constexpr const uptr kTsanShadowXor = 0x04000000000ull;
-  static constexpr const uptr kTsanShadowAdd = 0x00000000000ull;
-  static constexpr const uptr kVdsoBeg = 0x37f00000000ull;
-};
-
 // struct MappingAarch64_48 {
 //   // Keep same with MappingAarch64_39 since ASan allocator needs to know the
 //   // heap memory range at compile time.
@@ -592,61 +534,33 @@ struct MappingGoS390x {
 
 extern uptr vmaSize;
 
+/// On aarch64 the VMA size is only known at startup (InitializePlatformEarly).
+/// Like TSan, dispatch on it: vmaSize never changes afterwards, so the branch
+/// is always predicted. The switch is compiled out unless a VMA smaller than
+/// 48 bits is supported (XSAN_AARCH64_MIN_VMA), since the smaller ones die in
+/// InitializePlatformEarly.
 template <typename Func, typename... Args>
 ALWAYS_INLINE auto SelectMapping(Args... args) {
-  /// Now we do not support dynamic dispatch for different VMA in aarch64
+#if defined(__aarch64__) && !SANITIZER_APPLE && !SANITIZER_GO && \
+    XSAN_AARCH64_MIN_VMA < 48
+  switch (vmaSize) {
+#  if XSAN_AARCH64_MIN_VMA <= 39
+    case 39:
+      return Func::template Apply<MappingAarch64_39>(args...);
+#  endif
+    case 42:
+      return Func::template Apply<MappingAarch64_42>(args...);
+  }
+#endif
+  return Func::template Apply<XsanMapping>(args...);
+}
+
+/// For the parameters that are compiled into the instrumented code, hence
+/// cannot follow the VMA size, e.g., MSan's mapping (aarch64_48 only) and
+/// ASan's shadow offset (shared by all aarch64 mappings).
+template <typename Func, typename... Args>
+ALWAYS_INLINE auto SelectStaticMapping(Args... args) {
   return Func::template Apply<XsanMapping>(args...);
-  //   #if SANITIZER_GO
-  // #  if defined(__powerpc64__)
-  //   switch (vmaSize) {
-  //     case 46:
-  //       return Func::template Apply<MappingGoPPC64_46>(args...);
-  //     case 47:
-  //       return Func::template Apply<MappingGoPPC64_47>(args...);
-  //   }
-  // #  elif defined(__mips64)
-  //   return Func::template Apply<MappingGoMips64_47>(args...);
-  // #  elif defined(__s390x__)
-  //   return Func::template Apply<MappingGoS390x>(args...);
-  // #  elif defined(__aarch64__)
-  //   return Func::template Apply<MappingGoAarch64>(args...);
-  // #  elif SANITIZER_WINDOWS
-  //   return Func::template Apply<MappingGoWindows>(args...);
-  // #  else
-  //   return Func::template Apply<MappingGo48>(args...);
-  // #  endif
-  // #else  // SANITIZER_GO
-  // #  if SANITIZER_IOS && !SANITIZER_IOSSIM
-  //   return Func::template Apply<MappingAppleAarch64>(args...);
-  // #  elif defined(__x86_64__) || SANITIZER_APPLE
-  //   return Func::template Apply<Mapping48AddressSpace>(args...);
-  // #  elif defined(__aarch64__)
-  //   switch (vmaSize) {
-  //     // case 39:
-  //     //   return Func::template Apply<MappingAarch64_39>(args...);
-  //     // case 42:
-  //     //   return Func::template Apply<MappingAarch64_42>(args...);
-  //     case 48:
-  //       return Func::template Apply<MappingAarch64_48>(args...);
-  //   }
-  // #  elif defined(__powerpc64__)
-  //   switch (vmaSize) {
-  //     case 44:
-  //       return Func::template Apply<MappingPPC64_44>(args...);
-  //     case 46:
-  //       return Func::template Apply<MappingPPC64_46>(args...);
-  //     case 47:
-  //       return Func::template Apply<MappingPPC64_47>(args...);
-  //   }
-  // #  elif defined(__mips64)
-  //   return Func::template Apply<MappingMips64_40>(args...);
-  // #  elif defined(__s390x__)
-  //   return Func::template Apply<MappingS390x>(args...);
-  // #  else
-  // #    error "unsupported platform"
-  // #  endif
-  // #endif
-  // Die();
 }
 
 template <typename Func>
@@ -670,24 +584,33 @@ void ForEachMapping() {
   Func::template Apply<MappingGoS390x>();
 }
 
-#define XSAN_MAP_FUNC(ret, func, parameters, arguments)                 \
-  namespace mapping_impl {                                              \
-  struct func##Impl {                                                   \
-    template <typename Mapping>                                         \
-    static ret Apply parameters;                                        \
-  };                                                                    \
-  }                                                                     \
-  ALWAYS_INLINE ret func parameters {                                   \
-    return ::__xsan::SelectMapping<mapping_impl::func##Impl> arguments; \
-  }                                                                     \
-  template <typename Mapping>                                           \
+#define XSAN_MAP_FUNC_IMPL(select, ret, func, parameters, arguments) \
+  namespace mapping_impl {                                           \
+  struct func##Impl {                                                \
+    template <typename Mapping>                                      \
+    static ret Apply parameters;                                     \
+  };                                                                 \
+  }                                                                  \
+  ALWAYS_INLINE ret func parameters {                                \
+    return ::__xsan::select<mapping_impl::func##Impl> arguments;     \
+  }                                                                  \
+  template <typename Mapping>                                        \
   ALWAYS_INLINE ret mapping_impl::func##Impl::Apply parameters
 
+#define XSAN_MAP_FUNC(ret, func, parameters, arguments) \
+  XSAN_MAP_FUNC_IMPL(SelectMapping, ret, func, parameters, arguments)
+#define XSAN_STATIC_MAP_FUNC(ret, func, parameters, arguments) \
+  XSAN_MAP_FUNC_IMPL(SelectStaticMapping, ret, func, parameters, arguments)
+
 #define MAP_FIELD(field) Mapping::field
 
 #define XSAN_MAP_FUNC_VOID(ret, func) XSAN_MAP_FUNC(ret, func, (), ())
 #define XSAN_MAP_FIELD_FUNC(func, field) \
   XSAN_MAP_FUNC_VOID(uptr, func) { return MAP_FIELD(field); }
+#define XSAN_STATIC_MAP_FUNC_VOID(ret, func) \
+  XSAN_STATIC_MAP_FUNC(ret, func, (), ())
+#define XSAN_STATIC_MAP_FIELD_FUNC(func, field) \
+  XSAN_STATIC_MAP_FUNC_VOID(uptr, func) { return MAP_FIELD(field); }
 
 XSAN_MAP_FIELD_FUNC(LoAppMemBeg, kLoAppMemBeg)
 XSAN_MAP_FIELD_FUNC(LoAppMemEnd, kLoAppMemEnd)
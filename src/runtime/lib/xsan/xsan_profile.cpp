@@ -0,0 +1,200 @@
+//===-- xsan_profile.cpp --------------------------------------------------===//
+//
+// This file is a part of XSan, a composition of different Sanitizers.
+//
+// Sampling profiler of the cost of XSan's checks, see xsan_profile.h.
+//
+// The sites are kept in a fixed-size open addressing table keyed by the
+// location and the kind of the check, so that recording a sample takes no
+// lock. The counters of a sample are scaled by the sampling period when the
+// table is printed.
+//===----------------------------------------------------------------------===//
+
+#include "xsan_profile.h"
+
+#include "sanitizer_common/sanitizer_atomic.h"
+#include "sanitizer_common/sanitizer_flags.h"
+#include "sanitizer_common/sanitizer_symbolizer.h"
+#include "xsan_flags.h"
+#include "xsan_internal.h"
+
+namespace __xsan {
+
+u32 profile_period;
+
+static THREADLOCAL u32 profile_countdown;
+
+bool ProfileTick() {
+  if (profile_countdown) {
+    profile_countdown--;
+    return false;
+  }
+  profile_countdown = profile_period - 1;
+  return true;
+}
+
+struct ProfileSite {
+  // (pc << kKindBits) | kind, 0 if the slot is free.
+  atomic_uintptr_t key;
+  const char *name;
+  atomic_uint64_t samples;
+  atomic_uint64_t app_bytes;
+  atomic_uint64_t nanos[kProfileSanitizers];
+  atomic_uint64_t shadow_bytes[kProfileSanitizers];
+
+  uptr pc() const { return atomic_load_relaxed(&key) >> kKindBits; }
+  ProfileKind kind() const {
+    return (ProfileKind)(atomic_load_relaxed(&key) & ((1 << kKindBits) - 1));
+  }
+  u64 total_nanos() const {
+    u64 res = 0;
+    for (uptr i = 0; i < kProfileSanitizers; i++)
+      res += atomic_load_relaxed(&nanos[i]);
+    return res;
+  }
+
+  static constexpr uptr kKindBits = 3;
+};
+static_assert((uptr)ProfileKind::kCount <= 1 << ProfileSite::kKindBits, "");
+
+static const uptr kProfileSites = 1 << 14;
+static ProfileSite *profile_sites;
+static atomic_uint64_t profile_dropped;
+
+static const char *const kSanitizerNames[kProfileSanitizers] = {"asan", "msan",
+                                                                "tsan"};
+static const char *const kKindNames[] = {
+    "read",       "write",       "period-read", "period-write",
+    "range-read", "range-write", "interceptor",
+};
+static_assert(ARRAY_SIZE(kKindNames) == (uptr)ProfileKind::kCount, "");
+
+// The shadow a sub-sanitizer reads to check `app_bytes` bytes: one byte per
+// 8-byte granule for ASan, one byte per byte for MSan, and four 4-byte shadow
+// cells per 8-byte granule for TSan.
+static uptr ShadowBytes(uptr san, uptr app_bytes) {
+  switch ((XsanHooksSanitizer)san) {
+    case XsanHooksSanitizer::Asan:
+      return RoundUpTo(app_bytes, 8) / 8;
+    case XsanHooksSanitizer::Msan:
+      return app_bytes;
+    case XsanHooksSanitizer::Tsan:
+      return RoundUpTo(app_bytes, 8) * 2;
+  }
+  return 0;
+}
+
+static ProfileSite *FindOrInsertSite(uptr pc, ProfileKind kind) {
+  uptr key = (pc << ProfileSite::kKindBits) | (uptr)kind;
+  uptr h = key * 0x9E3779B97F4A7C15ull;
+  for (uptr probe = 0; probe < kProfileSites; probe++) {
+    ProfileSite *site = &profile_sites[(h + probe) % kProfileSites];
+    uptr cur = atomic_load(&site->key, memory_order_acquire);
+    if (cur == 0 && atomic_compare_exchange_strong(&site->key, &cur, key,
+                                                   memory_order_acq_rel))
+      return site;
+    // Either occupied, or lost the race for the free slot to `cur`.
+    if (cur == key)
+      return site;
+  }
+  return nullptr;
+}
+
+void ProfileRecord(uptr pc, ProfileKind kind, const char *name, uptr app_bytes,
+                   const ProfileSample &sample) {
+  if (UNLIKELY(!profile_sites || !pc))
+    return;
+  ProfileSite *site = FindOrInsertSite(pc, kind);
+  if (UNLIKELY(!site)) {
+    atomic_fetch_add(&profile_dropped, 1, memory_order_relaxed);
+    return;
+  }
+  if (name && !site->name)
+    site->name = name;
+  atomic_fetch_add(&site->samples, 1, memory_order_relaxed);
+  atomic_fetch_add(&site->app_bytes, app_bytes, memory_order_relaxed);
+  for (uptr i = 0; i < kProfileSanitizers; i++) {
+    if (!(sample.ran & (1u << i)))
+      continue;
+    atomic_fetch_add(&site->nanos[i], sample.nanos[i], memory_order_relaxed);
+    atomic_fetch_add(&site->shadow_bytes[i], ShadowBytes(i, app_bytes),
+                     memory_order_relaxed);
+  }
+}
+
+static void AtexitPrintProfile() { PrintProfile(); }
+
+void InitializeProfile() {
+  if (flags()->profile_checks <= 0)
+    return;
+  profile_sites = (ProfileSite *)MmapOrDie(kProfileSites * sizeof(ProfileSite),
+                                           "XSan profile");
+  profile_period = flags()->profile_checks;
+  Atexit(AtexitPrintProfile);
+}
+
+static void PrintSiteLocation(uptr pc) {
+  SymbolizedStack *frame = Symbolizer::GetOrInit()->SymbolizePC(pc);
+  const AddressInfo &info = frame->info;
+  if (info.file)
+    Printf("%s %s:%d:%d\n", info.function ? info.function : "??",
+           StripPathPrefix(info.file, common_flags()->strip_path_prefix),
+           info.line, info.column);
+  else
+    Printf("%s (%s+0x%zx)\n", info.function ? info.function : "??",
+           info.module ? StripModuleName(info.module) : "??",
+           info.module_offset);
+  frame->ClearAll();
+}
+
+void PrintProfile() {
+  if (!profile_sites)
+    return;
+  // The symbolizer runs interceptors, which must not change the table.
+  u64 period = profile_period;
+  profile_period = 0;
+
+  InternalMmapVector<ProfileSite *> sites;
+  for (uptr i = 0; i < kProfileSites; i++)
+    if (atomic_load_relaxed(&profile_sites[i].key))
+      sites.push_back(&profile_sites[i]);
+  Sort(sites.data(), sites.size(),
+       [](ProfileSite *const &a, ProfileSite *const &b) {
+         return a->total_nanos() > b->total_nanos();
+       });
+
+  u64 total_nanos[kProfileSanitizers] = {};
+  u64 total_shadow[kProfileSanitizers] = {};
+  Printf("XSan: check profile of %zu sites, 1 of every %llu checks sampled:\n",
+         sites.size(), period);
+  for (uptr i = 0; i < sites.size(); i++) {
+    ProfileSite *site = sites[i];
+    Printf("  #%zu %s%s%s checks: %llu, app bytes: %llu", i,
+           kKindNames[(uptr)site->kind()], site->name ? " " : "",
+           site->name ? site->name : "",
+           atomic_load_relaxed(&site->samples) * period,
+           atomic_load_relaxed(&site->app_bytes) * period);
+    for (uptr s = 0; s < kProfileSanitizers; s++) {
+      u64 ns = atomic_load_relaxed(&site->nanos[s]) * period;
+      u64 shadow = atomic_load_relaxed(&site->shadow_bytes[s]) * period;
+      if (!ns && !shadow)
+        continue;
+      Printf(", %s: %llu ns %llu shadow bytes", kSanitizerNames[s], ns, shadow);
+      total_nanos[s] += ns;
+      total_shadow[s] += shadow;
+    }
+    Printf("\n    in ");
+    PrintSiteLocation(site->pc());
+  }
+  Printf("XSan: check profile per sub-sanitizer:\n");
+  for (uptr s = 0; s < kProfileSanitizers; s++) {
+    if (!total_nanos[s] && !total_shadow[s])
+      continue;
+    Printf("  %s: %llu ns %llu shadow bytes\n", kSanitizerNames[s],
+           total_nanos[s], total_shadow[s]);
+  }
+  if (u64 dropped = atomic_load_relaxed(&profile_dropped))
+    Printf("XSan: %llu samples dropped, the site table is full\n", dropped);
+}
+
+}  // namespace __xsan
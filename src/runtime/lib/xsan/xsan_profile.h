@@ -0,0 +1,91 @@
+//===-- xsan_profile.h ------------------------------------------*- C++ -*-===//
+//
+// This file is a part of XSan, a composition of different Sanitizers.
+//
+// Sampling profiler of the cost of XSan's checks (see the profile_checks
+// flag). One out of every N outlined checks (__xsan_read/write*, the period
+// and range callbacks) and interceptor calls is sampled. The hooks of each
+// sub-sanitizer are timed separately and attributed to the calling source
+// location, and a table is printed at exit.
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include "sanitizer_common/sanitizer_common.h"
+#include "sanitizer_common/sanitizer_internal_defs.h"
+#include "sanitizer_common/sanitizer_stacktrace.h"
+#include "xsan_hooks_types.h"
+
+namespace __xsan {
+
+enum class ProfileKind : u8 {
+  Read,
+  Write,
+  PeriodRead,
+  PeriodWrite,
+  RangeRead,
+  RangeWrite,
+  // Range checks of an interceptor, attributed to the caller of it.
+  Interceptor,
+  kCount,
+};
+
+constexpr uptr kProfileSanitizers = (uptr)XsanHooksSanitizer::Tsan + 1;
+
+// The sampling period, or 0 if the profiler is disabled.
+extern u32 profile_period;
+
+bool ProfileTick();
+
+/// Costs a load and a branch if the profiler is disabled.
+ALWAYS_INLINE bool ProfileSampled() {
+  return UNLIKELY(profile_period != 0) && ProfileTick();
+}
+
+/// The cost of the sub-sanitizers for one sampled check.
+struct ProfileSample {
+  u64 nanos[kProfileSanitizers] = {};
+  // Bit mask of the sub-sanitizers that performed the check.
+  u32 ran = 0;
+
+  ALWAYS_INLINE void Add(XsanHooksSanitizer san, u64 ns) {
+    nanos[(uptr)san] += ns;
+    ran |= 1u << (uptr)san;
+  }
+};
+
+void ProfileRecord(uptr pc, ProfileKind kind, const char *name, uptr app_bytes,
+                   const ProfileSample &sample);
+
+void InitializeProfile();
+void PrintProfile();
+
+}  // namespace __xsan
+
+// The pc passed by the instrumentation, or the caller of the callback.
+#define XSAN_PROFILE_PC(pc) \
+  ((pc) ? (pc)              \
+        : ::__sanitizer::StackTrace::GetPreviousInstructionPc(GET_CALLER_PC()))
+
+// Evaluated in an interceptor: its caller if the call is sampled, 0 otherwise.
+#define XSAN_PROFILE_INTERCEPTOR_PC()                               \
+  (::__xsan::ProfileSampled()                                       \
+       ? ::__sanitizer::StackTrace::GetPreviousInstructionPc(       \
+             GET_CALLER_PC())                                       \
+       : 0)
+
+#define XSAN_PROFILE_HOOK(SAN, CALL)                                     \
+  do {                                                                   \
+    u64 _profile_t0 = ::__sanitizer::MonotonicNanoTime();               \
+    CALL;                                                                \
+    _profile_sample.Add(SAN,                                             \
+                        ::__sanitizer::MonotonicNanoTime() - _profile_t0); \
+  } while (0)
+
+/// XSAN_HOOKS_EXEC for a sampled check: times the hook of each sub-sanitizer
+/// and records it for the location PC.
+#define XSAN_HOOKS_EXEC_SAMPLED(PC, KIND, NAME, BYTES, FUNC, ...)         \
+  do {                                                                    \
+    ::__xsan::ProfileSample _profile_sample;                              \
+    XSAN_HOOKS_EXEC_PROFILED(XSAN_PROFILE_HOOK, FUNC, __VA_ARGS__);       \
+    ::__xsan::ProfileRecord(PC, KIND, NAME, BYTES, _profile_sample);      \
+  } while (0)
@@ -181,6 +181,10 @@ static bool XsanInitInternal() {
 
   __xsan::InitFromXsanLate();
 
+  InitializeShadowMemoryPolicy();
+
+  InitializeProfile();
+
   InitializeCoverage(common_flags()->coverage, common_flags()->coverage_dir);
 
   InstallAtForkHandler();
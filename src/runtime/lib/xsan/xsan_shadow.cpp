@@ -0,0 +1,91 @@
+//===-- xsan_shadow.cpp ---------------------------------------------------===//
+//
+// This file is a part of XSan, a composition of different Sanitizers.
+//
+// Residency policy of the shadow regions of the sub-sanitizers.
+//
+// Every sub-sanitizer reserves its shadow with MAP_NORESERVE and
+// MADV_NOHUGEPAGE (see no_huge_pages_for_shadow), so a shadow page costs
+// nothing until it is touched. The shadow of the heap is the exception to the
+// sparse access pattern: it is touched by every malloc/free of every
+// sub-sanitizer, so it is worth backing with transparent huge pages.
+//===----------------------------------------------------------------------===//
+
+#include <sanitizer_common/sanitizer_platform.h>
+
+#include "sanitizer_common/sanitizer_common.h"
+#include "sanitizer_common/sanitizer_mutex.h"
+#include "sanitizer_common/sanitizer_posix.h"
+#include "xsan_hooks.h"
+#include "xsan_internal.h"
+
+#if SANITIZER_LINUX
+#  include <sys/mman.h>
+#endif
+
+namespace __xsan {
+
+static void AtexitPrintShadowMemoryRss() { PrintShadowMemoryRss(); }
+
+void InitializeShadowMemoryPolicy() {
+#if SANITIZER_LINUX && defined(MADV_HUGEPAGE)
+  if (flags()->heap_shadow_huge_pages) {
+    SmallVector<NamedRange, 1024> hot_ranges;
+    HotShadowRanges(hot_ranges);
+    for (const auto &r : hot_ranges) {
+      uptr beg = RoundUpTo(r.range.begin, GetPageSizeCached());
+      uptr end = RoundDownTo(r.range.end, GetPageSizeCached());
+      if (beg >= end)
+        continue;
+      VPrintf(1, "XSan: huge pages for %s: 0x%zx-0x%zx\n", r.name, beg, end);
+      if (internal_iserror(internal_madvise(beg, end - beg, MADV_HUGEPAGE)))
+        VReport(1, "XSan: madvise(MADV_HUGEPAGE) failed for %s\n", r.name);
+    }
+  }
+#endif
+  if (flags()->print_shadow_rss)
+    Atexit(AtexitPrintShadowMemoryRss);
+}
+
+// The smaps callback only receives the start of each mapping, so the regions
+// are kept here while the profile is taken.
+static StaticSpinMutex rss_mu;
+static SmallVector<NamedRange, 1024> rss_ranges;
+
+static void FillShadowRssCallback(uptr start, uptr rss, bool file,
+                                  uptr *stats) {
+  uptr i = 0;
+  for (; i < rss_ranges.size(); i++) {
+    if (start >= rss_ranges[i].range.begin && start < rss_ranges[i].range.end)
+      break;
+  }
+  // The last slot accounts for everything outside of the shadow.
+  stats[i] += rss;
+}
+
+void PrintShadowMemoryRss() {
+#if SANITIZER_LINUX
+  SpinMutexLock l(&rss_mu);
+  rss_ranges.n = 0;
+  NeededMapRanges(rss_ranges);
+  uptr stats[decltype(rss_ranges)::N + 1] = {};
+  GetMemoryProfile(FillShadowRssCallback, stats);
+  uptr total = 0;
+  for (uptr i = 0; i <= rss_ranges.size(); i++) total += stats[i];
+  Printf("XSan: resident memory per region (total %zu KB):\n", total >> 10);
+  for (uptr i = 0; i < rss_ranges.size(); i++) {
+    if (!stats[i])
+      continue;
+    Printf("  %-24s 0x%zx-0x%zx: %zu KB\n", rss_ranges[i].name,
+           rss_ranges[i].range.begin, rss_ranges[i].range.end, stats[i] >> 10);
+  }
+  Printf("  %-24s %zu KB\n", "app and runtime",
+         stats[rss_ranges.size()] >> 10);
+#endif
+}
+
+}  // namespace __xsan
+
+using namespace __xsan;
+
+void __xsan_print_shadow_rss() { PrintShadowMemoryRss(); }
@@ -0,0 +1,132 @@
+//===-- xsan_simd.h ---------------------------------------------*- C++ -*-===//
+//
+// This file is a part of XSan, a composition of different Sanitizers.
+//
+// SIMD kernels shared by the sub-sanitizers to scan shadow memory in bulk,
+// and strings in the interceptors.
+// The widest instruction set enabled at compile time is used (AVX2, then
+// SSE2/SSE4.2), with a scalar fallback for the remaining bytes.
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "sanitizer_common/sanitizer_internal_defs.h"
+
+#if defined(__AVX2__)
+#  define XSAN_SIMD_AVX2 1
+#else
+#  define XSAN_SIMD_AVX2 0
+#endif
+
+#if defined(__SSE2__)
+#  define XSAN_SIMD_SSE 1
+#else
+#  define XSAN_SIMD_SSE 0
+#endif
+
+#if XSAN_SIMD_AVX2
+#  include <immintrin.h>
+#elif XSAN_SIMD_SSE
+#  include <emmintrin.h>
+#endif
+
+namespace __xsan {
+
+using ::__sanitizer::u32;
+using ::__sanitizer::u8;
+using ::__sanitizer::uptr;
+
+/// Return the offset of the first non-zero byte in [p, p + size), or `size`
+/// if all the bytes are zero.
+/// Shadow memory is mostly zero, hence the vector loops only leave the fast
+/// path when some lane reports a non-zero byte.
+ALWAYS_INLINE uptr FindFirstNonZeroByte(const u8 *p, uptr size) {
+  uptr i = 0;
+#if XSAN_SIMD_AVX2
+  for (; i + 32 <= size; i += 32) {
+    const __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+    if (LIKELY(_mm256_testz_si256(v, v)))
+      continue;
+    const u32 zero_mask = (u32)_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+    return i + __builtin_ctz(~zero_mask);
+  }
+#endif
+#if XSAN_SIMD_SSE
+  for (; i + 16 <= size; i += 16) {
+    const __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+    const u32 zero_mask =
+        (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+    if (LIKELY(zero_mask == 0xffff))
+      continue;
+    return i + __builtin_ctz(~zero_mask);
+  }
+#else
+  for (; i < size && ((uptr)(p + i) % sizeof(uptr)); ++i)
+    if (p[i])
+      return i;
+  for (; i + sizeof(uptr) <= size; i += sizeof(uptr)) {
+    if (LIKELY(!*(const uptr *)(p + i)))
+      continue;
+    break;
+  }
+#endif
+  for (; i < size; ++i)
+    if (p[i])
+      return i;
+  return size;
+}
+
+/// Return the length of the string `s`, like strlen, and call
+/// `on_piece(beg, end)` on the consecutive pieces [beg, end) of the string
+/// including its terminator, in the same loop that looks for the terminator.
+/// Each piece lies within one vector, so that `on_piece` only has a few shadow
+/// bytes to look at while the string is still in the cache.
+/// The vector loads are aligned and thus never cross a page boundary, though
+/// they may read the bytes around the string.
+template <typename OnPiece>
+ALWAYS_INLINE uptr ScanString(const char *s, OnPiece &&on_piece) {
+#if XSAN_SIMD_AVX2 || XSAN_SIMD_SSE
+#  if XSAN_SIMD_AVX2
+  constexpr uptr kVec = 32;
+  auto zero_mask = [](uptr p) {
+    const __m256i v = _mm256_load_si256((const __m256i *)p);
+    return (u32)_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+  };
+#  else
+  constexpr uptr kVec = 16;
+  auto zero_mask = [](uptr p) {
+    const __m128i v = _mm_load_si128((const __m128i *)p);
+    return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+  };
+#  endif
+  uptr beg = (uptr)s;
+  uptr p = beg & ~(kVec - 1);
+  // Drop the lanes before the string.
+  u32 mask = zero_mask(p) >> (beg - p);
+  while (!mask) {
+    p += kVec;
+    on_piece(beg, p);
+    beg = p;
+    mask = zero_mask(p);
+  }
+  const uptr end = beg + __builtin_ctz(mask) + 1;
+  on_piece(beg, end);
+  return end - 1 - (uptr)s;
+#else
+  constexpr uptr kPiece = 16;
+  uptr beg = (uptr)s;
+  uptr p = beg;
+  for (; *(const char *)p; ++p) {
+    if ((p + 1) % kPiece == 0) {
+      on_piece(beg, p + 1);
+      beg = p + 1;
+    }
+  }
+  on_piece(beg, p + 1);
+  return p - (uptr)s;
+#endif
+}
+
+}  // namespace __xsan
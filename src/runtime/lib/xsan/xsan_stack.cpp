@@ -4,8 +4,41 @@
 #include "xsan_hooks.h"
 #include "xsan_thread.h"
 
+#if XSAN_CONTAINS_TSAN
+#  include "tsan/tsan_rtl.h"
+#endif
+
 namespace __xsan {
 
+bool GetStackTraceFromShadowStack(BufferedStackTrace &stack, uptr pc,
+                                  uptr caller_pc, uptr max_size) {
+#if XSAN_CONTAINS_TSAN
+  if (UNLIKELY(!XsanInited()))
+    return false;
+  __tsan::ThreadState *thr = __tsan::cur_thread();
+  if (UNLIKELY(!thr->is_inited || !thr->shadow_stack))
+    return false;
+  // The shadow stack grows upwards, and holds the return address of each call
+  // of an instrumented function, so it is copied in reverse after the PCs of
+  // the current frame and its caller.
+  max_size = Min<uptr>(max_size, kStackTraceMax);
+  uptr size = 0;
+  stack.trace_buffer[size++] = pc;
+  stack.trace_buffer[size++] = caller_pc;
+  const uptr *frame = thr->shadow_stack_pos;
+  // TSan's interceptors also push their caller PC.
+  if (frame > thr->shadow_stack && frame[-1] == caller_pc)
+    frame--;
+  while (size < max_size && frame > thr->shadow_stack)
+    stack.trace_buffer[size++] = *--frame;
+  stack.size = size;
+  stack.top_frame_bp = 0;
+  return true;
+#else
+  return false;
+#endif
+}
+
 class ScopedUnwinding {
  public:
   ALWAYS_INLINE explicit ScopedUnwinding(XsanThread *t) : thread(t) {
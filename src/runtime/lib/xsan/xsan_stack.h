@@ -11,10 +11,13 @@
 
 namespace __xsan {
 
-PSEUDO_MACRO void GetStackTraceCopy(BufferedStackTrace& stack) {
-  if (RequireStackTraces<XsanStackTraceType::copy>()) {
-    GetStackTrace(stack, ::__xsan::flags()->store_context_size,
-                  common_flags()->fast_unwind_on_malloc);
+/// Unwinds the stack of a copy of [src, src + size) only if a sub-sanitizer
+/// needs it for this very copy, and leaves it empty otherwise. The size of the
+/// stack, i.e., store_context_size, is not even read in the latter case.
+PSEUDO_MACRO void GetStackTraceCopy(BufferedStackTrace& stack, const void* src,
+                                    uptr size) {
+  if (RequireStackTracesForCopy(src, size)) {
+    GetStackTraceStored(stack, ::__xsan::flags()->store_context_size);
   }
 }
 
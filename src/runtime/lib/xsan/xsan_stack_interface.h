@@ -5,6 +5,8 @@
 #include <sanitizer_common/sanitizer_stacktrace.h>
 
 #include "xsan_attribute.h"
+#include "xsan_common_defs.h"
+#include "xsan_flags.h"
 
 namespace __asan {
 u32 GetMallocContextSize();
@@ -32,6 +34,26 @@ PSEUDO_MACRO void GetStackTrace(BufferedStackTrace& stack, uptr max_size,
   }
 }
 
+// Fills the stack with pc, caller_pc and the frames of TSan's shadow stack,
+// without unwinding. Returns false if TSan's shadow stack is not available.
+bool GetStackTraceFromShadowStack(BufferedStackTrace& stack, uptr pc,
+                                  uptr caller_pc, uptr max_size);
+
+PSEUDO_MACRO bool UseShadowStackForMalloc() {
+  return XSAN_CONTAINS_TSAN && flags()->malloc_stack_from_tsan;
+}
+
+// The stacks stored on allocations, deallocations and copies may be taken from
+// TSan's shadow stack, see the malloc_stack_from_tsan flag.
+PSEUDO_MACRO void GetStackTraceStored(BufferedStackTrace& stack,
+                                      uptr max_size) {
+  if (max_size > 2 && UseShadowStackForMalloc() &&
+      GetStackTraceFromShadowStack(stack, StackTrace::GetCurrentPc(),
+                                   GET_CALLER_PC(), max_size))
+    return;
+  GetStackTrace(stack, max_size, common_flags()->fast_unwind_on_malloc);
+}
+
 PSEUDO_MACRO void GetStackTraceFatal(BufferedStackTrace& stack, uptr pc,
                                      uptr bp) {
   stack.Unwind(pc, bp, nullptr, common_flags()->fast_unwind_on_fatal);
@@ -46,8 +68,7 @@ PSEUDO_MACRO void GetStackTraceThread(BufferedStackTrace& stack) {
 }
 
 PSEUDO_MACRO void GetStackTraceMalloc(BufferedStackTrace& stack) {
-  GetStackTrace(stack, GetMallocContextSize(),
-                common_flags()->fast_unwind_on_malloc);
+  GetStackTraceStored(stack, GetMallocContextSize());
 }
 
 PSEUDO_MACRO void GetStackTraceFree(BufferedStackTrace& stack) {
@@ -215,6 +215,8 @@ void XsanThread::ThreadStart() {
     CHECK_EQ(this->stack_size(), 0U);
     SetThreadStackAndTls(nullptr);
     is_inited_ = true;
+    // XSan is initialized before the main thread starts.
+    xsan_thread_state.running = true;
     int local = 0;
     VReport(1, "T%d: stack [%p,%p) size 0x%zx; local=%p\n", tid(),
             (void *)stack_bottom_, (void *)stack_top_,
@@ -295,6 +297,7 @@ void XsanTSDDtor(void *tsd) {
   }
   ScopedBlockSignals block(nullptr);
   xsan_current_thread = nullptr;
+  xsan_thread_state.running = false;
   // Make sure that signal handler can not see a stale current thread pointer.
   atomic_signal_fence(memory_order_seq_cst);
   XsanThread::TSDDtor(tsd);
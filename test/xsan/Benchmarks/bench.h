@@ -0,0 +1,36 @@
+// Helpers shared by the XSan microbenchmarks. Each benchmark prints one line
+//   BENCH <name> <ns/op>
+// per measurement, which xsan_bench.py collects along with the maximum RSS.
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static inline unsigned long long bench_now_ns() {
+  timespec tp;
+  clock_gettime(CLOCK_MONOTONIC, &tp);
+  return tp.tv_sec * 1000000000ULL + tp.tv_nsec;
+}
+
+// The number of iterations, scaled by the optional first argument.
+static inline long bench_iters(int argc, char **argv, long base) {
+  return argc > 1 ? base * atol(argv[1]) : base;
+}
+
+static inline void bench_report(const char *name, unsigned long long ns,
+                                long ops) {
+  printf("BENCH %s %.3f\n", name, (double)ns / (ops ? ops : 1));
+  fflush(stdout);
+}
+
+// Runs the statement niter times and reports its average latency.
+#define BENCH(name, niter, stmt)                                  \
+  do {                                                            \
+    long bench_n_ = (niter);                                      \
+    unsigned long long bench_t0_ = bench_now_ns();                \
+    for (long bench_i_ = 0; bench_i_ < bench_n_; bench_i_++) {    \
+      stmt;                                                       \
+    }                                                             \
+    bench_report(name, bench_now_ns() - bench_t0_, bench_n_);     \
+  } while (0)
@@ -0,0 +1,29 @@
+// The string and memory intrinsic interceptors on short and long buffers.
+// RUN: %xsan_bench %s %t
+
+#include <string.h>
+
+#include "bench.h"
+
+static char src[1 << 16];
+static char dst[1 << 16];
+
+int main(int argc, char **argv) {
+  long n = bench_iters(argc, argv, 1 << 20);
+  memset(src, 'x', sizeof(src) - 1);
+  // Keep the calls from being folded or inlined by the compiler.
+  char *volatile vsrc = src;
+  char *volatile vdst = dst;
+  volatile size_t sink = 0;
+
+  BENCH("memcpy_16", n, memcpy(vdst, vsrc, 16));
+  BENCH("memcpy_4k", n / 16, memcpy(vdst, vsrc, 4096));
+  BENCH("memset_16", n, memset(vdst, 0, 16));
+  BENCH("memset_4k", n / 16, memset(vdst, 0, 4096));
+  vsrc[16] = 0;
+  BENCH("strlen_16", n, sink += strlen(vsrc));
+  vsrc[16] = 'x';
+  vsrc[4096] = 0;
+  BENCH("strlen_4k", n / 16, sink += strlen(vsrc));
+  return sink == 0;
+}
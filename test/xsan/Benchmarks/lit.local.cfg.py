@@ -0,0 +1,39 @@
+# -*- Python -*-
+
+import os
+import shlex
+
+# The microbenchmarks are only run by check-xsan-bench, which sets xsan_bench.
+if not lit_config.params.get("xsan_bench"):
+    config.unsupported = True
+
+clangxx_xsan = next(
+    (v for k, v in config.substitutions if k == "%clangxx_xsan "), ""
+).strip()
+output = lit_config.params.get(
+    "xsan_bench_output", os.path.join(config.test_exec_root, "bench-results")
+)
+xsan_bench = os.path.join(os.path.dirname(__file__), "xsan_bench.py")
+config.substitutions.append(
+    (
+        "%xsan_bench",
+        " ".join(
+            [
+                shlex.quote(config.python_executable),
+                shlex.quote(xsan_bench),
+                "--compiler",
+                shlex.quote(clangxx_xsan),
+                "--sanitizers",
+                shlex.quote(config.xsan_bench_sanitizers),
+                "--combos",
+                shlex.quote(lit_config.params.get("xsan_bench_combos", "")),
+                "--args",
+                shlex.quote(lit_config.params.get("xsan_bench_args", "")),
+                "--output",
+                shlex.quote(output),
+            ]
+        ),
+    )
+)
+
+config.suffixes = [".cpp"]
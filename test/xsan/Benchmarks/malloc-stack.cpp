@@ -0,0 +1,39 @@
+// malloc/free called 32 frames deep, with the allocation stacks unwound or
+// copied from TSan's shadow stack.
+// RUN: %env_xsan_opts=malloc_stack_from_tsan=0 %xsan_bench %s %t
+// RUN: %env_xsan_opts=malloc_stack_from_tsan=1 %xsan_bench %s %t
+
+#include <string.h>
+
+#include "bench.h"
+
+static const int kBatch = 16;
+
+__attribute__((noinline)) void *alloc_at_depth(int depth, size_t size) {
+  if (depth == 0)
+    return malloc(size);
+  void *p = alloc_at_depth(depth - 1, size);
+  // Keep the recursion from being turned into a loop.
+  *(volatile char *)p = 0;
+  return p;
+}
+
+int main(int argc, char **argv) {
+  long n = bench_iters(argc, argv, 1 << 10);
+  // Both runs append to the same results, so tell them apart by the flag.
+  const char *opts = getenv("XSAN_OPTIONS");
+  bool from_tsan = opts && strstr(opts, "malloc_stack_from_tsan=1");
+
+  void *blocks[kBatch];
+  unsigned long long t0 = bench_now_ns();
+  for (long i = 0; i < n; i++) {
+    for (int j = 0; j < kBatch; j++)
+      blocks[j] = alloc_at_depth(32, 8 << (j % 6));
+    for (int j = 0; j < kBatch; j++)
+      free(blocks[j]);
+  }
+  bench_report(from_tsan ? "malloc_free_depth32_tsan_stack"
+                         : "malloc_free_depth32_unwound",
+               bench_now_ns() - t0, 2L * n * kBatch);
+  return 0;
+}
@@ -0,0 +1,43 @@
+// malloc/free of small blocks with 1 to 64 threads, reported per operation of
+// each thread. Each thread also frees a block from a TSD destructor, i.e.,
+// after TSan has destroyed its Processor.
+// RUN: %xsan_bench %s %t
+
+#include <pthread.h>
+
+#include "bench.h"
+
+static const int kBatch = 16;
+static long niter;
+static pthread_key_t key;
+
+static void tsd_dtor(void *p) { free(p); }
+
+static void *worker(void *) {
+  void *blocks[kBatch];
+  for (long i = 0; i < niter; i++) {
+    for (int j = 0; j < kBatch; j++)
+      blocks[j] = malloc(8 << (j % 6));
+    for (int j = 0; j < kBatch; j++)
+      free(blocks[j]);
+  }
+  pthread_setspecific(key, malloc(64));
+  return nullptr;
+}
+
+int main(int argc, char **argv) {
+  niter = bench_iters(argc, argv, 1 << 12);
+  pthread_key_create(&key, tsd_dtor);
+  pthread_t th[64];
+  for (int nth = 1; nth <= 64; nth *= 2) {
+    unsigned long long t0 = bench_now_ns();
+    for (int i = 0; i < nth; i++)
+      pthread_create(&th[i], nullptr, worker, nullptr);
+    for (int i = 0; i < nth; i++)
+      pthread_join(th[i], nullptr);
+    char name[32];
+    snprintf(name, sizeof(name), "malloc_free_t%d", nth);
+    bench_report(name, bench_now_ns() - t0, 2L * niter * kBatch);
+  }
+  return 0;
+}
@@ -0,0 +1,54 @@
+// The outlined checks of XSan, i.e., __xsan_read/write{1..16}, and the range
+// and period callbacks emitted by the loop optimizations.
+// RUN: %xsan_bench %s %t
+
+#include "bench.h"
+
+typedef unsigned long uptr;
+typedef long s64;
+
+extern "C" {
+#define DECLARE_CHECKS(size)                                                 \
+  void __xsan_read##size(const void *p, uptr pc);                            \
+  void __xsan_write##size(const void *p, uptr pc);                           \
+  void __xsan_period_read##size(const void *beg, const void *end, s64 step,  \
+                                uptr pc);                                    \
+  void __xsan_period_write##size(const void *beg, const void *end, s64 step, \
+                                 uptr pc);
+DECLARE_CHECKS(1)
+DECLARE_CHECKS(2)
+DECLARE_CHECKS(4)
+DECLARE_CHECKS(8)
+DECLARE_CHECKS(16)
+#undef DECLARE_CHECKS
+void __xsan_read_range(const void *beg, const void *end, uptr pc);
+void __xsan_write_range(const void *beg, const void *end, uptr pc);
+}
+
+alignas(64) static char buf[1 << 16];
+
+int main(int argc, char **argv) {
+  long n = bench_iters(argc, argv, 1 << 22);
+  char *volatile vbuf = buf;
+  char *p = vbuf;
+
+#define BENCH_CHECKS(size)                                                     \
+  BENCH("read" #size, n, __xsan_read##size(p + (bench_i_ & 63) * 16, 0));      \
+  BENCH("write" #size, n, __xsan_write##size(p + (bench_i_ & 63) * 16, 0));    \
+  BENCH("period_read" #size "_x64", n / 64,                                    \
+        __xsan_period_read##size(p, p + 64 * 2 * size, 2 * size, 0));          \
+  BENCH("period_write" #size "_x64", n / 64,                                   \
+        __xsan_period_write##size(p, p + 64 * 2 * size, 2 * size, 0));
+  BENCH_CHECKS(1)
+  BENCH_CHECKS(2)
+  BENCH_CHECKS(4)
+  BENCH_CHECKS(8)
+  BENCH_CHECKS(16)
+#undef BENCH_CHECKS
+
+  BENCH("read_range_64", n, __xsan_read_range(p, p + 64, 0));
+  BENCH("write_range_64", n, __xsan_write_range(p, p + 64, 0));
+  BENCH("read_range_4k", n / 64, __xsan_read_range(p, p + 4096, 0));
+  BENCH("write_range_4k", n / 64, __xsan_write_range(p, p + 4096, 0));
+  return 0;
+}
@@ -0,0 +1,36 @@
+// The thread, fork and signal paths of the runtime: pthread_create/join,
+// fork/waitpid and the delivery of a synchronous signal to a handler.
+// RUN: %xsan_bench %s %t
+
+#include <pthread.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+static void *nop(void *arg) { return arg; }
+
+static volatile sig_atomic_t nsignals;
+static void handler(int) { nsignals++; }
+
+int main(int argc, char **argv) {
+  long n = bench_iters(argc, argv, 1 << 10);
+
+  BENCH("pthread_create_join", n, {
+    pthread_t th;
+    pthread_create(&th, nullptr, nop, nullptr);
+    pthread_join(th, nullptr);
+  });
+
+  BENCH("fork_waitpid", n / 16, {
+    pid_t pid = fork();
+    if (pid == 0)
+      _exit(0);
+    waitpid(pid, nullptr, 0);
+  });
+
+  signal(SIGUSR1, handler);
+  BENCH("raise_signal", n * 16, raise(SIGUSR1));
+  return nsignals == 0;
+}
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+"""Builds an XSan microbenchmark for each combination of sub-sanitizers, runs
+it, and emits one JSON object per measurement:
+
+  {"bench": "malloc-threads", "name": "malloc_free_t8",
+   "sanitizers": "address+thread", "ns_per_op": 61.2, "max_rss_kb": 40212}
+
+The results are printed and appended to <output>/<bench>.jsonl.
+"""
+
+import argparse
+import itertools
+import json
+import os
+import shlex
+import subprocess
+import sys
+
+
+def combinations(sanitizers, base):
+    """All the combinations including the base sanitizer, e.g., ASan which
+    provides the allocator, smallest first."""
+    others = [s for s in sanitizers if s != base]
+    for n in range(len(others) + 1):
+        for extra in itertools.combinations(others, n):
+            yield [base] + list(extra)
+
+
+def run(cmd, **kwargs):
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE, **kwargs)
+    out = proc.stdout.read().decode()
+    _, status, rusage = os.wait4(proc.pid, 0)
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    return proc.returncode, out, rusage.ru_maxrss
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--compiler", required=True,
+                        help="the command compiling with all of XSan")
+    parser.add_argument("--sanitizers", required=True,
+                        help="the sanitizers XSan is built with, e.g., "
+                        "address;thread;memory")
+    parser.add_argument("--combos", default="",
+                        help="only run these combinations, e.g., "
+                        "address,address+thread")
+    parser.add_argument("--output", required=True)
+    parser.add_argument("--args", default="",
+                        help="arguments of the benchmark, e.g., a scale")
+    parser.add_argument("source")
+    parser.add_argument("binary")
+    args = parser.parse_args()
+
+    sanitizers = [s for s in args.sanitizers.split(";") if s]
+    base = "address" if "address" in sanitizers else sanitizers[0]
+    combos = list(combinations(sanitizers, base))
+    if args.combos:
+        wanted = set(args.combos.split(","))
+        combos = [c for c in combos if "+".join(c) in wanted]
+
+    bench = os.path.splitext(os.path.basename(args.source))[0]
+    os.makedirs(args.output, exist_ok=True)
+    failed = False
+    with open(os.path.join(args.output, bench + ".jsonl"), "a") as results:
+        for combo in combos:
+            name = "+".join(combo)
+            binary = "%s.%s" % (args.binary, name)
+            disabled = [s for s in sanitizers if s not in combo]
+            cmd = shlex.split(args.compiler) + ["-O2", args.source, "-o", binary]
+            if disabled:
+                cmd.append("-fno-sanitize=" + ",".join(disabled))
+            if subprocess.call(cmd) != 0:
+                print("error: failed to build %s with %s" % (bench, name),
+                      file=sys.stderr)
+                failed = True
+                continue
+            code, out, max_rss_kb = run([binary] + shlex.split(args.args))
+            if code != 0:
+                print("error: %s with %s exited with %d" % (bench, name, code),
+                      file=sys.stderr)
+                failed = True
+            for line in out.splitlines():
+                fields = line.split()
+                if len(fields) != 3 or fields[0] != "BENCH":
+                    continue
+                record = {
+                    "bench": bench,
+                    "name": fields[1],
+                    "sanitizers": name,
+                    "ns_per_op": float(fields[2]),
+                    "max_rss_kb": max_rss_kb,
+                }
+                print(json.dumps(record))
+                results.write(json.dumps(record) + "\n")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
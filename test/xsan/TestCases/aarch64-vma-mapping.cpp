@@ -0,0 +1,37 @@
+// The heap must be placed in the layout of the VMA size the process runs with.
+// The smaller VMA sizes can be tested under qemu-user, e.g., with
+// COMPILER_RT_EMULATOR="qemu-aarch64 -R 0x8000000000" for the 39-bit VMA,
+// which requires a runtime built with -DXSAN_AARCH64_MIN_VMA=39 and no MSan.
+// REQUIRES: aarch64-target-arch
+// RUN: %clangxx_xsan -O0 %s -o %t
+// RUN: %run %t 2>&1 | FileCheck %s
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main() {
+  unsigned long frame = (unsigned long)__builtin_frame_address(0);
+  int vma = 64 - __builtin_clzl(frame);
+  unsigned long beg, end;
+  switch (vma) {
+  case 39:
+    beg = 0x007900000000UL;
+    end = 0x007d00000000UL;
+    break;
+  case 42:
+    beg = 0x03d000000000UL;
+    end = 0x03e000000000UL;
+    break;
+  default:
+    beg = 0xd80000000000UL;
+    end = 0xda0000000000UL;
+    break;
+  }
+  void *p = malloc(32);
+  unsigned long a = (unsigned long)p;
+  fprintf(stderr, "vma=%d heap=%d\n", vma, a >= beg && a < end);
+  free(p);
+  return 0;
+}
+
+// CHECK: heap=1
@@ -0,0 +1,23 @@
+// A reused heap chunk must still be uninitialized for MSan when the free hooks
+// are delivered on recycling. TSan needs the free hooks at free time, so the
+// flag only has an effect without it.
+// RUN: %clangxx_xsan -O0 -fno-sanitize=thread %s -o %t
+// RUN: %env_xsan_opts=batch_alloc_free_hooks=1:quarantine_size_mb=0 not %run %t 2>&1 | FileCheck %s
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main() {
+  volatile int *p = (int *)malloc(16 * sizeof(int));
+  for (int i = 0; i < 16; i++)
+    p[i] = i;
+  free((void *)p);
+  volatile int *q = (int *)malloc(16 * sizeof(int));
+  // CHECK: reused: 1
+  fprintf(stderr, "reused: %d\n", p == q);
+  // CHECK: WARNING: MemorySanitizer: use-of-uninitialized-value
+  if (q[3])
+    puts("initialized");
+  free((void *)q);
+  return 0;
+}
@@ -0,0 +1,34 @@
+// TSan still sees a free racing with an earlier unsynchronized write of
+// another thread when the free hooks of the other sanitizers are delayed.
+// RUN: %clangxx_xsan -O1 %s -o %t
+// RUN: %env_xsan_opts=batch_alloc_free_hooks=1 not %run %t 2>&1 | FileCheck %s
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int written;
+
+static void *writer(void *arg) {
+  *(int *)arg = 1;
+  // A relaxed store does not order the write before the free.
+  __atomic_store_n(&written, 1, __ATOMIC_RELAXED);
+  return nullptr;
+}
+
+int main() {
+  int *p = (int *)malloc(16 * sizeof(int));
+  pthread_t t;
+  pthread_create(&t, nullptr, writer, p);
+  while (!__atomic_load_n(&written, __ATOMIC_RELAXED))
+    ;
+  free(p);
+  pthread_join(t, nullptr);
+  fprintf(stderr, "DONE\n");
+  return 0;
+}
+
+// CHECK: WARNING: ThreadSanitizer: data race
+// CHECK: Write of size
+// CHECK: #0 free
+// CHECK: DONE
@@ -0,0 +1,36 @@
+// The check of an argument before a call is dropped if the callee checks it on
+// every call, which still catches an overflow in the callee.
+// RUN: %clangxx_xsan -O1 -mllvm -xsan-stats -c %s -o %t.o 2>&1 | FileCheck %s
+// RUN: %clangxx_xsan -O1 %s -o %t
+// RUN: %run %t 2 2>&1 | FileCheck %s --check-prefix=OK
+// RUN: not %run %t 1 2>&1 | FileCheck %s --check-prefix=OVERFLOW
+
+#include <stdio.h>
+#include <stdlib.h>
+
+__attribute__((noinline)) void set(long *p, long x) { p[1] = x; }
+
+// The load of p[1] is covered by the store to it in set().
+__attribute__((noinline)) void bump(long *p) {
+  long v = p[1];
+  set(p, v + 1);
+}
+
+int main(int argc, char **argv) {
+  long *p = (long *)calloc(atoi(argv[1]), sizeof(long));
+  bump(p);
+  bump(p);
+  printf("p[1] = %ld\n", p[1]);
+  free(p);
+  return 0;
+}
+
+// CHECK: XSan statistics
+// CHECK-DAG: {{[1-9][0-9]*}} xsan-checked-args - Number of functions checking their arguments on every call
+// CHECK-DAG: {{[1-9][0-9]*}} xsan-mopir - Number of MOP checks covered by the argument checks of callees
+
+// OK: p[1] = 2
+
+// OVERFLOW: ERROR: AddressSanitizer: heap-buffer-overflow
+// OVERFLOW: WRITE of size 8
+// OVERFLOW: in set
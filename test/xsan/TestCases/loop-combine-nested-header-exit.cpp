@@ -0,0 +1,41 @@
+// The checks of an inner loop that exits from its header are combined after
+// the outer loop, and still cover the row read by its last run.
+// RUN: %clangxx_xsan -O1 -mllvm -rotation-max-header-size=0 -mllvm -xsan-stats \
+// RUN:   -c %s -o %t.o 2>&1 | FileCheck %s
+// RUN: %clangxx_xsan -O1 -mllvm -rotation-max-header-size=0 %s -o %t
+// RUN: %run %t 4 2>&1 | FileCheck %s --check-prefix=OK
+// RUN: not %run %t 5 2>&1 | FileCheck %s --check-prefix=OVERFLOW
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// The outer loop exits from its latch, while loop rotation is disabled to keep
+// the inner loop exiting from its header.
+__attribute__((noinline)) long sum_rows(const int *a, long n) {
+  long s = 0;
+  long i = 0;
+  do {
+#pragma clang loop unroll(disable)
+    for (long j = 0; j < 16; j++)
+      s += a[i * 16 + j];
+  } while (++i < n);
+  return s;
+}
+
+int main(int argc, char **argv) {
+  int *a = (int *)malloc(64 * sizeof(int));
+  for (int i = 0; i < 64; i++)
+    a[i] = i;
+  printf("sum = %ld\n", sum_rows(a, atoi(argv[1])));
+  free(a);
+  return 0;
+}
+
+// CHECK: XSan statistics
+// CHECK: {{[1-9][0-9]*}} xsan_opt - Number of MOPs combined after the outer loops of their nests
+
+// OK: sum = 2016
+
+// OVERFLOW: ERROR: AddressSanitizer: heap-buffer-overflow
+// OVERFLOW: READ of size
+// OVERFLOW: in sum_rows
@@ -0,0 +1,61 @@
+// The checks of a loop are combined after the outer loop of the nest if the
+// rows are adjacent, on each exit of a multi-exit loop, and in a loop with
+// calls that never free or synchronize, which still catches an overflow.
+// RUN: %clangxx_xsan -O1 -mllvm -xsan-stats -c %s -o %t.o 2>&1 | FileCheck %s
+// RUN: %clangxx_xsan -O1 %s -o %t
+// RUN: %run %t 4 2>&1 | FileCheck %s --check-prefix=OK
+// RUN: not %run %t 5 2>&1 | FileCheck %s --check-prefix=OVERFLOW
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int hist[16];
+
+// Each run of the inner loop reads the row right after the last one.
+__attribute__((noinline)) long sum_rows(const int *a, long n) {
+  long s = 0;
+  for (long i = 0; i < n; i++) {
+#pragma clang loop unroll(disable)
+    for (long j = 0; j < 16; j++)
+      s += a[i * 16 + j];
+  }
+  return s;
+}
+
+// The loop exits either on the key or at the end.
+__attribute__((noinline)) long find(const int *a, long n, int key) {
+  for (long i = 0; i < n; i++)
+    if (a[i] == key)
+      return i;
+  return -1;
+}
+
+__attribute__((noinline)) void bump(int v) { hist[v & 15]++; }
+
+__attribute__((noinline)) void tally(const int *a, long n) {
+  for (long i = 0; i < n; i++)
+    bump(a[i]);
+}
+
+int main(int argc, char **argv) {
+  int *a = (int *)malloc(64 * sizeof(int));
+  for (int i = 0; i < 64; i++)
+    a[i] = i;
+  long s = sum_rows(a, atoi(argv[1]));
+  tally(a, 64);
+  printf("sum = %ld find = %ld hist = %d\n", s, find(a, 64, 40), hist[3]);
+  free(a);
+  return 0;
+}
+
+// CHECK: XSan statistics
+// CHECK-DAG: {{[1-9][0-9]*}} xsan_opt - Number of MOPs whose checks are combined after their loops
+// CHECK-DAG: {{[1-9][0-9]*}} xsan_opt - Number of MOPs combined on each exit of multi-exit loops
+// CHECK-DAG: {{[1-9][0-9]*}} xsan_opt - Number of MOPs combined after the outer loops of their nests
+// CHECK-DAG: {{[1-9][0-9]*}} xsan_opt - Number of combinable loops with calls that never free or sync
+
+// OK: sum = 2016 find = 40 hist = 4
+
+// OVERFLOW: ERROR: AddressSanitizer: heap-buffer-overflow
+// OVERFLOW: READ of size
+// OVERFLOW: in sum_rows
@@ -0,0 +1,31 @@
+// The checks of an array scoped in a loop body are not moved after the loop,
+// where the array is out of scope, even if it is only passed to calls that
+// never free or synchronize.
+// RUN: %clangxx_xsan -O1 %s -o %t
+// RUN: %run %t 4 2>&1 | FileCheck %s
+
+#include <stdio.h>
+#include <stdlib.h>
+
+__attribute__((noinline)) void fill(int *p, int v) {
+  for (int k = 0; k < 4; k++)
+    p[k] = v + k;
+}
+
+__attribute__((noinline)) long sum_scoped(int n) {
+  long s = 0;
+  for (int i = 0; i < n; i++) {
+    int buf[4];
+    fill(buf, i);
+    s += buf[0] + buf[3];
+  }
+  return s;
+}
+
+int main(int argc, char **argv) {
+  printf("sum = %ld\n", sum_scoped(atoi(argv[1])));
+  return 0;
+}
+
+// CHECK-NOT: stack-use-after-scope
+// CHECK: sum = 24
@@ -0,0 +1,38 @@
+// The adjacent accesses of a versioned loop are only coalesced in the original
+// loop, as the clone runs without ASan's checks.
+// RUN: %clangxx_xsan -O1 -mllvm -xsan-disable-tsan -mllvm -xsan-loop-opt=no \
+// RUN:   -mllvm -xsan-stats -c %s -o %t.o 2>&1 | FileCheck %s
+// RUN: %clangxx_xsan -O1 -mllvm -xsan-disable-tsan -mllvm -xsan-loop-opt=no \
+// RUN:   %s -o %t
+// RUN: %run %t 4 2>&1 | FileCheck %s --check-prefix=OK
+// RUN: not %run %t 5 2>&1 | FileCheck %s --check-prefix=OVERFLOW
+
+#include <stdio.h>
+#include <stdlib.h>
+
+__attribute__((noinline)) long sum_quads(const long *a, int n) {
+  long s = 0;
+  for (int i = 0; i < n; i++)
+    s += a[4 * i] + a[4 * i + 1] + a[4 * i + 2] + a[4 * i + 3];
+  return s;
+}
+
+int main(int argc, char **argv) {
+  long *a = (long *)malloc(16 * sizeof(long));
+  for (int i = 0; i < 16; i++)
+    a[i] = i;
+  printf("sum = %ld\n", sum_quads(a, atoi(argv[1])));
+  free(a);
+  return 0;
+}
+
+// The four loads of the clone would double both counts below.
+// CHECK: XSan statistics
+// CHECK-DAG: {{[1-9][0-9]*}} xsan_opt - Number of loops versioned by the ranges they access
+// CHECK-DAG: {{^ +}}4 xsan-mopir - Number of MOPs coalesced by MopIR
+// CHECK-DAG: {{^ +}}1 xsan-mopir - Number of wide checks of coalesced MOPs inserted by MopIR
+
+// OK: sum = 120
+
+// OVERFLOW: ERROR: AddressSanitizer: heap-buffer-overflow
+// OVERFLOW: READ of size 8
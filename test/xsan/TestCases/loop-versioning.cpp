@@ -0,0 +1,44 @@
+// A loop whose accessed ranges are computable before it is versioned: the clone
+// without ASan's checks runs if the ranges are clean, while the instrumented
+// loop still catches an overflow.
+// RUN: %clangxx_xsan -O1 -mllvm -xsan-disable-tsan -mllvm -xsan-stats \
+// RUN:   -c %s -o %t.o 2>&1 | FileCheck %s
+// RUN: %clangxx_xsan -O1 -mllvm -xsan-disable-tsan -mllvm -xsan-stats \
+// RUN:   -mllvm -xsan-loop-versioning=0 -c %s -o %t.o 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=OFF
+// RUN: %clangxx_xsan -O1 -mllvm -xsan-disable-tsan %s -o %t
+// RUN: %run %t 16 2>&1 | FileCheck %s --check-prefix=OK
+// RUN: not %run %t 17 2>&1 | FileCheck %s --check-prefix=OVERFLOW
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// The load of a[i + 1] is in a branch.
+__attribute__((noinline)) long sum_odd(const int *a, int n) {
+  long s = 0;
+  for (int i = 0; i < n - 1; i++)
+    if (a[i] & 1)
+      s += a[i + 1];
+  return s;
+}
+
+int main(int argc, char **argv) {
+  int *a = (int *)malloc(16 * sizeof(int));
+  for (int i = 0; i < 16; i++)
+    a[i] = i;
+  printf("sum = %ld\n", sum_odd(a, atoi(argv[1])));
+  free(a);
+  return 0;
+}
+
+// CHECK: XSan statistics
+// CHECK-DAG: {{[1-9][0-9]*}} xsan_opt - Number of loops versioned by the ranges they access
+// CHECK-DAG: {{[1-9][0-9]*}} xsan_opt - Number of MOPs unchecked by ASan in the versioned loops
+
+// OFF: XSan statistics
+// OFF-NOT: Number of loops versioned
+
+// OK: sum = 56
+
+// OVERFLOW: ERROR: AddressSanitizer: heap-buffer-overflow
+// OVERFLOW: READ of size 4
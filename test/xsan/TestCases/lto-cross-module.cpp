@@ -0,0 +1,36 @@
+// Under LTO, the modules are instrumented in the linker, after the accessor of
+// another module has been inlined, and the overflow through it is still caught.
+// REQUIRES: lto
+// RUN: %clangxx_xsan_lto -O2 -DPART=0 -c %s -o %t-0.o
+// RUN: %clangxx_xsan_lto -O2 -DPART=1 -c %s -o %t-1.o
+// RUN: %clangxx_xsan_lto -O2 -mllvm -xsan-stats %t-0.o %t-1.o -o %t 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=STATS
+// RUN: %run %t 3 2>&1 | FileCheck %s --check-prefix=OK
+// RUN: not %run %t 4 2>&1 | FileCheck %s
+
+#include <stdio.h>
+#include <stdlib.h>
+
+void set(int *p, int i, int v);
+
+#if PART == 1
+void set(int *p, int i, int v) { p[i] = v; }
+#else
+int main(int argc, char **argv) {
+  int *p = (int *)malloc(4 * sizeof(int));
+  set(p, atoi(argv[1]), 1);
+  printf("p[3] = %d\n", p[3]);
+  free(p);
+  return 0;
+}
+#endif
+
+// The statistics are printed by the linker.
+// STATS: XSan statistics
+// STATS: xsan-mopir - Number of MOPs seen by the MopIR pipeline
+
+// OK: p[3] = 1
+
+// CHECK: ERROR: AddressSanitizer: heap-buffer-overflow
+// CHECK: WRITE of size 4
+// CHECK: in main
@@ -0,0 +1,29 @@
+// The allocation stack of a heap-use-after-free is reported whether it is
+// unwound or copied from TSan's shadow stack.
+// RUN: %clangxx_xsan -O1 %s -o %t
+// RUN: %env_xsan_opts=malloc_stack_from_tsan=0 not %run %t 2>&1 | FileCheck %s
+// RUN: %env_xsan_opts=malloc_stack_from_tsan=1 not %run %t 2>&1 | FileCheck %s
+
+#include <stdlib.h>
+
+__attribute__((noinline)) void *alloc_at_depth(int depth, size_t size) {
+  if (depth == 0)
+    return malloc(size);
+  void *p = alloc_at_depth(depth - 1, size);
+  // Keep the recursion from being turned into a loop.
+  *(volatile char *)p = 0;
+  return p;
+}
+
+int main() {
+  volatile char *p = (char *)alloc_at_depth(4, 16);
+  free((void *)p);
+  return p[0];
+}
+
+// CHECK: ERROR: AddressSanitizer: heap-use-after-free
+// CHECK: freed by thread T0 here:
+// CHECK: in main
+// CHECK: previously allocated by thread T0 here:
+// CHECK: in alloc_at_depth
+// CHECK: in main
@@ -0,0 +1,52 @@
+// Small memcpy and memset of a constant length are expanded into loads and
+// stores, which still catch an overflow, while the larger ones call the
+// runtime.
+// RUN: %clangxx_xsan -O1 -mllvm -xsan-stats -c %s -o %t.o 2>&1 | FileCheck %s
+// RUN: %clangxx_xsan -O1 -mllvm -xsan-stats \
+// RUN:   -mllvm -xsan-inline-memintrin-size=0 -c %s -o %t.o 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=OFF
+// RUN: %clangxx_xsan -O1 %s -o %t
+// RUN: %run %t 12 2>&1 | FileCheck %s --check-prefix=OK
+// RUN: not %run %t 8 2>&1 | FileCheck %s --check-prefix=OVERFLOW
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct S {
+  int a, b, c;
+};
+
+__attribute__((noinline)) void copy(S *dst, const S *src) {
+  memcpy(dst, src, sizeof(S));
+}
+
+__attribute__((noinline)) void clear(char *p, int c) { memset(p, c, 16); }
+
+__attribute__((noinline)) void clear_large(char *p) { memset(p, 0, 256); }
+
+int main(int argc, char **argv) {
+  // Only the first fields are allocated if fewer than 12 bytes are.
+  S *src = (S *)malloc(atoi(argv[1]));
+  char buf[256];
+  clear(buf, 1);
+  clear_large(buf);
+  memset(src, 0, atoi(argv[1]));
+  S dst;
+  copy(&dst, src);
+  printf("dst.a = %d\n", dst.a + buf[0]);
+  free(src);
+  return 0;
+}
+
+// CHECK: XSan statistics
+// CHECK: {{[1-9][0-9]*}} xsan - Number of small memintrinsics expanded into loads and stores
+
+// OFF: XSan statistics
+// OFF-NOT: Number of small memintrinsics expanded
+
+// OK: dst.a = 0
+
+// OVERFLOW: ERROR: AddressSanitizer: heap-buffer-overflow
+// OVERFLOW: READ of size
+// OVERFLOW: in copy
@@ -0,0 +1,41 @@
+// The contiguous accesses of a block are checked at once by a wide check,
+// which still catches an overflow in any of them and reports its field.
+// RUN: %clangxx_xsan -O1 -mllvm -xsan-stats -c %s -o %t.o 2>&1 | FileCheck %s
+// RUN: %clangxx_xsan -O1 %s -o %t
+// RUN: %run %t 4 2>&1 | FileCheck %s --check-prefix=OK
+// RUN: not %run %t 3 2>&1 | FileCheck %s --check-prefix=OVERFLOW
+
+#include <stdio.h>
+#include <stdlib.h>
+
+struct S {
+  long a, b, c, d;
+};
+
+__attribute__((noinline)) void fill(S *s, long x) {
+  s->a = x;
+  s->b = x + 1;
+  s->c = x + 2;
+  s->d = x + 3;
+}
+
+__attribute__((noinline)) long sum(S *s) { return s->a + s->b + s->c + s->d; }
+
+int main(int argc, char **argv) {
+  // Only the first fields are allocated if fewer than 4 longs are.
+  S *s = (S *)malloc(atoi(argv[1]) * sizeof(long));
+  fill(s, 1);
+  printf("sum = %ld\n", sum(s));
+  free(s);
+  return 0;
+}
+
+// CHECK: XSan statistics
+// CHECK-DAG: {{[1-9][0-9]*}} xsan-mopir - Number of MOPs coalesced by MopIR
+// CHECK-DAG: {{[1-9][0-9]*}} xsan-mopir - Number of wide checks of coalesced MOPs inserted by MopIR
+
+// OK: sum = 10
+
+// OVERFLOW: ERROR: AddressSanitizer: heap-buffer-overflow
+// OVERFLOW: WRITE of size 8
+// OVERFLOW: 0 bytes after 24-byte region
@@ -0,0 +1,40 @@
+// The MopIR pipeline elides the checks once for all sub-sanitizers, and an
+// empty -xsan-mop-pipeline falls back to the reduction of each sub-sanitizer.
+// RUN: %clangxx_xsan -O1 -mllvm -xsan-stats -c %s -o %t.o 2>&1 | FileCheck %s
+// RUN: %clangxx_xsan -O1 -mllvm -xsan-stats -mllvm -xsan-mop-pipeline= \
+// RUN:   -c %s -o %t.o 2>&1 | FileCheck %s --check-prefix=LEGACY
+// RUN: %clangxx_xsan -O1 -mllvm -xsan-stats \
+// RUN:   -mllvm -xsan-mop-pipeline=redundant-write -c %s -o %t.o 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=WRITE
+// RUN: not %clangxx_xsan -O1 -mllvm -xsan-mop-pipeline=bogus -c %s -o %t.o 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=BOGUS
+
+// The first store to *p is overwritten before any call, and may not be removed
+// as *q might alias *p.
+void overwrite(int *p, int *q) {
+  *p = 1;
+  *p = *q + 1;
+}
+
+// The load of each field is covered by the store to it.
+struct S {
+  long a, b;
+};
+void bump(S *s, long x) {
+  s->a += x;
+  s->b += x;
+}
+
+// CHECK: XSan statistics
+// CHECK-DAG: {{[1-9][0-9]*}} xsan-mopir - Number of MOP checks elided by MopIR
+// CHECK-DAG: {{[1-9][0-9]*}} xsan-recurrence-reducer - Number of recurent checks reduced
+
+// LEGACY: XSan statistics
+// LEGACY-NOT: xsan-mopir
+// LEGACY: xsan-recurrence-reducer - Number of recurent checks reduced
+
+// WRITE: XSan statistics
+// WRITE-NOT: xsan-recurrence-reducer
+// WRITE: xsan-mopir - Number of MOP checks elided by MopIR
+
+// BOGUS: Unknown pass 'bogus' in -xsan-mop-pipeline
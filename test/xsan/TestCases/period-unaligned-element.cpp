@@ -0,0 +1,33 @@
+// A sparse periodic check of unaligned 16-byte elements catches a poisoned
+// granule in the middle of an element.
+// RUN: %clangxx_xsan -O1 %s -o %t
+// RUN: %run %t 0 2>&1 | FileCheck %s --check-prefix=OK
+// RUN: not %run %t 1 2>&1 | FileCheck %s --check-prefix=POISONED
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+extern "C" {
+void __asan_poison_memory_region(void const volatile *addr, size_t size);
+void __xsan_period_read16(const void *beg, const void *end, long step,
+                          size_t pc);
+}
+
+int main(int argc, char **argv) {
+  // The period is longer than the span scanned densely.
+  const long kStep = 1024;
+  char *buf = (char *)malloc(4 * kStep);
+  // Each element [4, 20) spans the granules at 0, 8 and 16.
+  char *beg = buf + kStep + 4;
+  if (atoi(argv[1]))
+    __asan_poison_memory_region(beg + 4, 8);
+  __xsan_period_read16(beg, beg + 2 * kStep, kStep, 0);
+  printf("Done\n");
+  return 0;
+}
+
+// OK: Done
+
+// POISONED: ERROR: AddressSanitizer: use-after-poison
+// POISONED: READ of size 16
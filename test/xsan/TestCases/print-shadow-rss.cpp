@@ -0,0 +1,15 @@
+// RUN: %clangxx_xsan -O1 %s -o %t
+// RUN: %env_xsan_opts=print_shadow_rss=1:heap_shadow_huge_pages=1 %run %t 2>&1 | FileCheck %s
+
+#include <stdlib.h>
+#include <string.h>
+
+int main() {
+  char *p = (char *)malloc(1 << 20);
+  memset(p, 1, 1 << 20);
+  free(p);
+  return 0;
+}
+
+// CHECK: XSan: resident memory per region (total {{[0-9]+}} KB):
+// CHECK: app and runtime
@@ -0,0 +1,34 @@
+// With profile_checks=1 every check is sampled, and the range checks of the
+// interceptors are attributed to their callers.
+// RUN: %clangxx_xsan -O1 %s -o %t
+// RUN: %env_xsan_opts=profile_checks=1 %run %t 2>&1 | FileCheck %s
+// RUN: %run %t 2>&1 | FileCheck %s --check-prefix=NOPROF
+
+#include <stdio.h>
+#include <string.h>
+
+static char src[4096], dst[4096];
+
+__attribute__((noinline)) static size_t copy(int i) {
+  memcpy(dst, src, sizeof(src) - i);
+  return strlen(dst);
+}
+
+int main() {
+  size_t n = 0;
+  memset(src, 'a', sizeof(src) - 1);
+  for (int i = 1; i < 1000; i++)
+    n += copy(i);
+  fprintf(stderr, "DONE %zu\n", n > 0);
+  return 0;
+}
+
+// CHECK: DONE 1
+// CHECK: XSan: check profile of {{[1-9][0-9]*}} sites, 1 of every 1 checks sampled:
+// CHECK: interceptor memcpy checks: {{[1-9][0-9]*}}
+// CHECK-NEXT: in copy{{.*}}profile-checks.cpp:13
+// CHECK: XSan: check profile per sub-sanitizer:
+// CHECK: asan: {{[0-9]+}} ns {{[1-9][0-9]*}} shadow bytes
+
+// NOPROF: DONE 1
+// NOPROF-NOT: XSan: check profile
@@ -0,0 +1,24 @@
+// The recurring checks of a function are reduced, and the cost of doing so is
+// reported with -xsan-stats. With no budget, no pair of MOPs is compared.
+// RUN: %clangxx_xsan -O1 -mllvm -xsan-stats -c %s -o %t.o 2>&1 | FileCheck %s
+// RUN: %clangxx_xsan -O1 -mllvm -xsan-stats -mllvm -xsan-reduce-rec-budget=0 \
+// RUN:   -c %s -o %t.o 2>&1 | FileCheck %s --check-prefix=NOBUDGET
+
+struct S {
+  long a, b, c;
+};
+
+// The load of each field is covered by the store to it.
+void bump(S *s, long x) {
+  s->a += x;
+  s->b += x;
+  s->c += x;
+}
+
+// CHECK: XSan statistics
+// CHECK-DAG: {{[1-9][0-9]*}} xsan-recurrence-reducer - Number of recurent checks reduced
+// CHECK-DAG: {{[1-9][0-9]*}} xsan-recurrence-reducer - Number of pairs of MOPs compared
+
+// NOBUDGET: XSan statistics
+// NOBUDGET-NOT: Number of recurent checks reduced
+// NOBUDGET: xsan-recurrence-reducer - Number of functions exceeding -xsan-reduce-rec-budget
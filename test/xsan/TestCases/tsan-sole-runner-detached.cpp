@@ -0,0 +1,36 @@
+// A detached worker that exits without being joined keeps the elision off,
+// so its race with main is still reported.
+// RUN: %clangxx_xsan -O1 %s -o %t
+// RUN: %env_xsan_opts=tsan_sole_runner_elision=1 not %run %t 2>&1 | FileCheck %s
+
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+
+static int g;
+static int done;
+
+static void *worker(void *) {
+  g = 1;
+  __atomic_store_n(&done, 1, __ATOMIC_RELAXED);
+  return nullptr;
+}
+
+int main() {
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  pthread_t t;
+  pthread_create(&t, &attr, worker, nullptr);
+  pthread_attr_destroy(&attr);
+  while (!__atomic_load_n(&done, __ATOMIC_RELAXED))
+    ;
+  // Let the worker exit first.
+  usleep(100000);
+  g = 2;
+  fprintf(stderr, "DONE\n");
+  return 0;
+}
+
+// CHECK: WARNING: ThreadSanitizer: data race
+// CHECK: DONE
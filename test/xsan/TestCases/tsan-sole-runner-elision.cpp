@@ -0,0 +1,54 @@
+// Accesses of a worker running alone while main blocks in pthread_join are
+// elided, while races between two running threads are still reported.
+// RUN: %clangxx_xsan -O1 %s -o %t
+// RUN: %env_xsan_opts=tsan_sole_runner_elision=1:verbosity=1 not %run %t 2>&1 | FileCheck %s
+
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+
+static volatile int data[1000];
+static int g;
+static int done, racy;
+
+static void *solo(void *) {
+  // Give main the time to block in pthread_join.
+  usleep(100000);
+  for (int i = 0; i < 1000; i++)
+    data[i] = i;
+  return nullptr;
+}
+
+static void *racer1(void *) {
+  while (!__atomic_load_n(&done, __ATOMIC_RELAXED))
+    ;
+  g = 1;
+  __atomic_store_n(&racy, 1, __ATOMIC_RELAXED);
+  return nullptr;
+}
+
+static void *racer2(void *) {
+  g = 2;
+  __atomic_store_n(&done, 1, __ATOMIC_RELAXED);
+  // Stay alive until racer1 has raced with us.
+  while (!__atomic_load_n(&racy, __ATOMIC_RELAXED))
+    ;
+  return nullptr;
+}
+
+int main() {
+  pthread_t t1, t2;
+  pthread_create(&t1, nullptr, solo, nullptr);
+  pthread_join(t1, nullptr);
+
+  pthread_create(&t1, nullptr, racer1, nullptr);
+  pthread_create(&t2, nullptr, racer2, nullptr);
+  pthread_join(t1, nullptr);
+  pthread_join(t2, nullptr);
+  fprintf(stderr, "DONE\n");
+  return 0;
+}
+
+// CHECK: WARNING: ThreadSanitizer: data race
+// CHECK: DONE
+// CHECK: ThreadSanitizer: sole-runner elision: {{[1-9][0-9]*}} accesses elided in {{[0-9]+}} periods
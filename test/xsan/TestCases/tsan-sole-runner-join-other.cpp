@@ -0,0 +1,41 @@
+// A worker running while main is joining another, already finished worker
+// does not elide its accesses, so its race with main is still reported.
+// RUN: %clangxx_xsan -O1 %s -o %t
+// RUN: %env_xsan_opts=tsan_sole_runner_elision=1 not %run %t 2>&1 | FileCheck %s
+
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+
+static int g;
+static int done, racy;
+
+static void *quick(void *) { return nullptr; }
+
+static void *slow(void *) {
+  // Let quick finish and main leave pthread_join first.
+  usleep(100000);
+  g = 1;
+  __atomic_store_n(&done, 1, __ATOMIC_RELAXED);
+  // Stay alive until main has raced with us.
+  while (!__atomic_load_n(&racy, __ATOMIC_RELAXED))
+    ;
+  return nullptr;
+}
+
+int main() {
+  pthread_t t1, t2;
+  pthread_create(&t2, nullptr, slow, nullptr);
+  pthread_create(&t1, nullptr, quick, nullptr);
+  pthread_join(t1, nullptr);
+  while (!__atomic_load_n(&done, __ATOMIC_RELAXED))
+    ;
+  g = 2;
+  __atomic_store_n(&racy, 1, __ATOMIC_RELAXED);
+  pthread_join(t2, nullptr);
+  fprintf(stderr, "DONE\n");
+  return 0;
+}
+
+// CHECK: WARNING: ThreadSanitizer: data race
+// CHECK: DONE
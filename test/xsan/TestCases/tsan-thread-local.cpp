@@ -0,0 +1,53 @@
+// TSan does not check the stack and heap objects that never leave the thread,
+// while a heap object handed to another thread is still checked.
+// RUN: %clangxx_xsan -O1 -mllvm -xsan-stats -c %s -o %t.o 2>&1 | FileCheck %s
+// RUN: %clangxx_xsan -O1 -mllvm -xsan-stats \
+// RUN:   -mllvm -xsan-tsan-opt-thread-local=0 -c %s -o %t.o 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=OFF
+// RUN: %clangxx_xsan -O1 %s -o %t
+// RUN: not %run %t 2>&1 | FileCheck %s --check-prefix=RACE
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Neither the array nor the buffer escapes, even though the buffer is freed.
+__attribute__((noinline)) long local_sum(int n) {
+  long a[16];
+  long *b = (long *)malloc(16 * sizeof(long));
+  for (int i = 0; i < 16; i++) {
+    a[(i * n) & 15] = i;
+    b[(i + n) & 15] = i;
+  }
+  long s = 0;
+  for (int i = 0; i < 16; i++)
+    s += a[(i ^ n) & 15] + b[(i * n) & 15];
+  free(b);
+  return s;
+}
+
+static void *worker(void *arg) {
+  *(long *)arg += 1;
+  return nullptr;
+}
+
+int main(int argc, char **argv) {
+  long *shared = (long *)malloc(sizeof(long));
+  *shared = local_sum(argc);
+  pthread_t t;
+  pthread_create(&t, nullptr, worker, shared);
+  *shared += 2;
+  pthread_join(t, nullptr);
+  fprintf(stderr, "DONE %ld\n", *shared > 0 ? 1L : 0L);
+  free(shared);
+  return 0;
+}
+
+// CHECK: XSan statistics
+// CHECK: {{[1-9][0-9]*}} tsan - Number of TSan checks of thread-local objects removed
+
+// OFF: XSan statistics
+// OFF-NOT: Number of TSan checks of thread-local objects removed
+
+// RACE: WARNING: ThreadSanitizer: data race
+// RACE: DONE 1
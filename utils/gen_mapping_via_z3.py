@@ -83,6 +83,8 @@ class TSanPlatformConfig(SanitizerPlatformConfig):
     meta_shadow_size: int = 4
     # Meta shadow memory's alignment.
     meta_alignment: int = 0x1000_0000_0000
+    # Reports keep that many low bits of an address (kCompressedAddrBits).
+    compressed_addr_bits: int = 44
 
 
 @dataclass
@@ -237,6 +239,14 @@ class ShadowMapper(ABC):
                 code += f"{indent}static constexpr const uintptr {key} = 0x{format_cpp_int(value)}ull;\n"
         return code
 
+    def get_formulas_as_cpp_code(self, fused: bool, in_header_file=False) -> str:
+        """Emit constexpr shadow formulas, consumed by the runtime and passes.
+
+        If `fused` is set, the formulas are built on the shared base
+        `ShadowBase(p)` (see SanitizerShadowAllocator.add_fusion_constraints).
+        """
+        return ""
+
     def format_parameters(self, model) -> Dict[str, int]:
         """Extract and format parameters from Z3 model"""
         params = self.get_parameters()
@@ -307,6 +317,15 @@ class ASanMapper(ShadowMapper):
         # ASan uses fixed values, no constraints needed
         pass
 
+    def get_formulas_as_cpp_code(self, fused: bool, in_header_file=False) -> str:
+        # ASan's shadow offset is fixed by the ABI, it never shares the base.
+        indent = "  " if in_header_file else ""
+        return (
+            f"{indent}static constexpr uintptr AsanMemToShadow(uintptr p) {{\n"
+            f"{indent}  return (p >> kAsanShadowScale) + kAsanShadowOffset;\n"
+            f"{indent}}}\n"
+        )
+
     def get_parameters_as_cpp_code(self, model, in_header_file=False) -> str:
         """Print sanitizer-specific parameters as C++ code"""
         params = self.format_parameters(model)
@@ -383,6 +402,18 @@ class MSanMapper(ShadowMapper):
         optimizer.add(self.kMSanShadowXor % self.config.xor_alignment == 0)
         optimizer.add(self.kMSanShadowAdd % platform.alignment == 0)
 
+    def get_formulas_as_cpp_code(self, fused: bool, in_header_file=False) -> str:
+        indent = "  " if in_header_file else ""
+        base = "ShadowBase(p)" if fused else "(p ^ kMSanShadowXor)"
+        return (
+            f"{indent}static constexpr uintptr MSanMemToShadow(uintptr p) {{\n"
+            f"{indent}  return {base};\n"
+            f"{indent}}}\n"
+            f"{indent}static constexpr uintptr MSanMemToOrigin(uintptr p) {{\n"
+            f"{indent}  return {base} + kMSanShadowAdd;\n"
+            f"{indent}}}\n"
+        )
+
 
 class TSanMapper(ShadowMapper):
     """ThreadSanitizer shadow mapper"""
@@ -530,12 +561,35 @@ class TSanMapper(ShadowMapper):
         optimizer.add(self.kTsanMetaShadowBeg >= platform.lo_app_mem_end_loose)
         optimizer.add(self.kTsanMetaShadowBeg % self.config.meta_alignment == 0)
 
-        # TSan requires the [41:44] bits of the app region to be distinguishable.
-        self._add_app_distinguishable_constraints(optimizer)
+        # TSan requires the [41:44] bits of the app region to be distinguishable,
+        # unless the whole address space survives the compression.
+        if platform.hi_app_end > 1 << self.config.compressed_addr_bits:
+            self._add_app_distinguishable_constraints(optimizer)
         # There is no solution under x64_48 with such implicit constraints
         # We specialize the relevant template to support such comment out.
         # self._add_heap_constraints(optimizer)
 
+    def get_formulas_as_cpp_code(self, fused: bool, in_header_file=False) -> str:
+        indent = "  " if in_header_file else ""
+        cfg = self.config
+        # kTsanShadowXor is zero if fused, and the mask drops the bits of
+        # kMSanShadowXor from the shared base.
+        base = "ShadowBase(p)" if fused else "p"
+        shadow = f"({base} & ~(kTsanShadowMsk | {cfg.shadow_cell - 1}))"
+        if not fused:
+            shadow = f"({shadow} ^ kTsanShadowXor)"
+        meta = f"({base} & ~(kTsanShadowMsk | {cfg.meta_shadow_cell - 1}))"
+        return (
+            f"{indent}static constexpr uintptr TsanMemToShadow(uintptr p) {{\n"
+            f"{indent}  return {shadow} * {cfg.shadow_multiplier} + kTsanShadowAdd;\n"
+            f"{indent}}}\n"
+            f"{indent}static constexpr uintptr TsanMemToMeta(uintptr p) {{\n"
+            f"{indent}  return {meta} / {cfg.meta_shadow_cell} * "
+            f"{cfg.meta_shadow_size} |\n"
+            f"{indent}         kTsanMetaShadowBeg;\n"
+            f"{indent}}}\n"
+        )
+
 
 # Platform configurations
 """
@@ -647,13 +701,87 @@ PLATFORMS = {
             ),
         ],
     ),
+    # MSan's shadow is baked into the instrumented code and only supports
+    # aarch64_48, hence the layouts of the smaller VMAs only carry ASan and
+    # TSan. ASan's shadow offset is the same for all aarch64 VMAs.
+    "aarch64_39": PlatformConfig(
+        name="MappingAarch64_39",
+        alignment=0x0001_0000_0000,  # 4GB alignment
+        lo_app_mem_beg=0x0000_0000_0000,
+        lo_app_mem_end=0x0001_0000_0000 - PAGE_SIZE,
+        lo_app_mem_end_loose=0x0001_0000_0000,
+        mid_app_beg=0x0055_0000_0000,
+        mid_app_end=0x0056_0000_0000,
+        hi_app_beg=0x007E_0000_0000,
+        hi_app_end=0x0080_0000_0000,
+        vdso_beg=0x007F_0000_0000,
+        min_heap_size=0x0004_0000_0000,
+        sanitizer_mappers=[
+            (
+                ASanMapper,
+                ASanPlatformConfig(
+                    shadow_offset=0x0010_0000_0000,
+                    shadow_scale=3,
+                ),
+            ),
+            (
+                TSanMapper,
+                TSanPlatformConfig(
+                    shadow_mask=0x0078_0000_0000,
+                    shadow_cell=8,
+                    shadow_multiplier=2,
+                    meta_shadow_cell=8,
+                    meta_shadow_size=4,
+                    meta_alignment=0x0010_0000_0000,
+                ),
+            ),
+        ],
+    ),
+    "aarch64_42": PlatformConfig(
+        name="MappingAarch64_42",
+        alignment=0x0010_0000_0000,  # 64GB alignment
+        lo_app_mem_beg=0x0000_0000_0000,
+        lo_app_mem_end=0x0010_0000_0000 - PAGE_SIZE,
+        lo_app_mem_end_loose=0x0010_0000_0000,
+        mid_app_beg=0x02AA_0000_0000,
+        mid_app_end=0x02AB_0000_0000,
+        hi_app_beg=0x03F0_0000_0000,
+        hi_app_end=0x0400_0000_0000,
+        vdso_beg=0x037F_0000_0000,
+        min_heap_size=0x0010_0000_0000,
+        sanitizer_mappers=[
+            (
+                ASanMapper,
+                ASanPlatformConfig(
+                    shadow_offset=0x0010_0000_0000,
+                    shadow_scale=3,
+                ),
+            ),
+            (
+                TSanMapper,
+                TSanPlatformConfig(
+                    shadow_mask=0x03C0_0000_0000,
+                    shadow_cell=8,
+                    shadow_multiplier=2,
+                    meta_shadow_cell=8,
+                    meta_shadow_size=4,
+                    meta_alignment=0x0100_0000_0000,
+                ),
+            ),
+        ],
+    ),
 }
 
 
 class SanitizerShadowAllocator:
     """Main allocator class with extensible sanitizer support"""
 
-    def __init__(self, platform_name: str, align_hint: Optional[int] = None):
+    def __init__(
+        self,
+        platform_name: str,
+        align_hint: Optional[int] = None,
+        fuse_shadow: bool = True,
+    ):
         if platform_name not in PLATFORMS:
             raise KeyError(
                 f"Unknown platform '{platform_name}'. Available: {list(PLATFORMS.keys())}"
@@ -663,6 +791,9 @@ class SanitizerShadowAllocator:
         if align_hint is not None:
             self.platform.alignment = align_hint
         self.optimizer = Optimize()
+        self.fuse_shadow = fuse_shadow
+        # Whether the solution satisfies the fusion constraints.
+        self.fused = False
 
         # Application memory regions (variables)
         self.kLoAppMemBeg = BitVec("kLoAppMemBeg", 64)
@@ -792,6 +923,31 @@ class SanitizerShadowAllocator:
         ):
             self.optimizer.add(Or(r1_end <= r2_beg, r2_end <= r1_beg))
 
+    def _find_mapper(self, mapper_type):
+        return next((s for s in self.sanitizers if isinstance(s, mapper_type)), None)
+
+    def add_fusion_constraints(self) -> bool:
+        """
+        Make MSan shadow, MSan origin, TSan shadow and TSan meta share one base
+        operation, i.e., `ShadowBase(p) = p ^ kMSanShadowXor`:
+          - MSan shadow = ShadowBase(p)
+          - MSan origin = ShadowBase(p) + kMSanShadowAdd
+          - TSan shadow = (ShadowBase(p) & ~(kTsanShadowMsk | 7)) * 2 + Add
+          - TSan meta   = (ShadowBase(p) & ~(kTsanShadowMsk | 7)) / 8 * 4 | Beg
+        This holds iff kTsanShadowXor == 0 and kMSanShadowXor only has bits in
+        kTsanShadowMsk, which TSan masks off. When instrumenting an access for
+        several sanitizers, the xor (and the masked value) is computed once.
+        Returns False if there is nothing to fuse.
+        """
+        msan = self._find_mapper(MSanMapper)
+        tsan = self._find_mapper(TSanMapper)
+        if msan is None or tsan is None:
+            return False
+        opt = self.optimizer
+        opt.add(tsan.kTsanShadowXor == 0)
+        opt.add(msan.kMSanShadowXor & ~tsan.config.shadow_mask == 0)
+        return True
+
     def solve(self, max_solutions: int = 1):
         """Solve the constraint system"""
         print(f"Platform: {self.platform_key}")
@@ -811,7 +967,18 @@ class SanitizerShadowAllocator:
 
         print("Solving...")
         results = []
-        res = self.optimizer.check()
+        if self.fuse_shadow:
+            self.optimizer.push()
+            if self.add_fusion_constraints():
+                res = self.optimizer.check()
+                if res == sat:
+                    self.fused = True
+                else:
+                    print("No layout with fused shadow formulas, falling back...")
+            if not self.fused:
+                self.optimizer.pop()
+        if not self.fused:
+            res = self.optimizer.check()
 
         if res == sat:
             print("Solution found!")
@@ -931,6 +1098,8 @@ class SanitizerShadowAllocator:
             code = sanitizer.get_parameters_as_cpp_code(solution)
             print(code)
 
+        print(self.get_formulas_cppcode(in_header_file=False))
+
         print("\n// Complete Memory Layout:")
         desc = self.get_memory_layout_desc(regions)
         print(desc)
@@ -952,6 +1121,25 @@ class SanitizerShadowAllocator:
             prev_end = end
         return desc
 
+    def get_formulas_cppcode(self, in_header_file=False) -> str:
+        """Get the C++ code of the shadow formulas of all sanitizers"""
+        indent = "  " if in_header_file else ""
+        code = f"{indent}// Shadow Formulas:\n"
+        if self.fused:
+            code += (
+                f"{indent}// MSan's and TSan's formulas share ShadowBase(); TSan masks off\n"
+                f"{indent}// the bits of kMSanShadowXor.\n"
+                f"{indent}static constexpr bool kFusedShadowBase = true;\n"
+                f"{indent}static constexpr uintptr ShadowBase(uintptr p) {{\n"
+                f"{indent}  return p ^ kMSanShadowXor;\n"
+                f"{indent}}}\n"
+            )
+        else:
+            code += f"{indent}static constexpr bool kFusedShadowBase = false;\n"
+        for sanitizer in self.sanitizers:
+            code += sanitizer.get_formulas_as_cpp_code(self.fused, in_header_file)
+        return code
+
     def get_regions_cppcode(self, regions) -> str:
         """Get the C++ code for the regions"""
         lines = []
@@ -1052,12 +1240,14 @@ class SanitizerShadowAllocator:
             parameters.append(code)
 
         parameters_code = "\n".join(parameters)
+        formulas_code = self.get_formulas_cppcode(in_header_file=True)
         regions_code = self.get_regions_cppcode(regions)
         header_code = f"""{header_comments}
 #pragma once
 {mapping_comments}
 struct {classname} {{
 {parameters_code}
+{formulas_code}
 {regions_code}
 }};
 """
@@ -1107,6 +1297,12 @@ def parse_args(argv=None):
         default=None,
         help="Optional override for platform alignment (e.g. 0x100000000000)",
     )
+    p.add_argument(
+        "--no-fuse-shadow",
+        dest="fuse_shadow",
+        action="store_false",
+        help="Do not search for layouts where the shadow formulas share a base",
+    )
     p.add_argument(
         "--max-solutions",
         type=int,
@@ -1121,7 +1317,9 @@ def main(argv=None):
 
     # Create allocator
     allocator = SanitizerShadowAllocator(
-        platform_name=args.platform, align_hint=args.align
+        platform_name=args.platform,
+        align_hint=args.align,
+        fuse_shadow=args.fuse_shadow,
     )
 
     # Solve
@@ -23,6 +23,11 @@ option(XSAN_CONTAINS_ASAN "Enable AddressSanitizer (ASan) globally" ON)
 # This option is used to enable or disable UndefinedBehaviorSanitizer (UBSan) globally.
 option(XSAN_CONTAINS_UBSAN "Enable UndefinedBehaviorSanitizer (UBSan) globally" ON)
 
+# Define XSAN_AARCH64_MIN_VMA to the smallest VMA size (39, 42 or 48) that the
+# aarch64 runtime supports. The mapping is selected by the VMA size at startup,
+# but ASan's heap can only be as large as the smallest supported heap.
+set(XSAN_AARCH64_MIN_VMA 48 CACHE STRING "Smallest aarch64 VMA size supported by XSan (39, 42 or 48)")
+
 # Define XSAN_USE_GCC_SPEC to control whether to use custom GCC spec file or livepatch
 # When ON: Use custom spec file to remove default sanitizer linking (preferred)
 # When OFF: Use livepatch approach to modify GCC's link_command_spec at runtime (fallback)